@@ -0,0 +1,406 @@
+#include "AABBTree.h"
+#include "Geometry/Plane.h"
+
+#include <algorithm>
+#include <assert.h>
+
+static inline AABB Union(const AABB& a, const AABB& b)
+{
+	AABB box = a;
+	box.Enclose(b);
+	return box;
+}
+
+// Half the surface area is enough to compare insertion costs
+static inline float Perimeter(const AABB& box)
+{
+	const float3 size = box.maxPoint - box.minPoint;
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+AABBTree::AABBTree()
+{
+}
+
+int AABBTree::CreateProxy(const AABB& box, GameObject* object)
+{
+	const int proxy = AllocateNode();
+
+	const float3 margin(AABB_TREE_MARGIN, AABB_TREE_MARGIN, AABB_TREE_MARGIN);
+	nodes[proxy].box.minPoint = box.minPoint - margin;
+	nodes[proxy].box.maxPoint = box.maxPoint + margin;
+	nodes[proxy].object = object;
+	nodes[proxy].height = 0;
+
+	InsertLeaf(proxy);
+	++proxyCount;
+
+	return proxy;
+}
+
+void AABBTree::DestroyProxy(int proxy)
+{
+	assert(nodes[proxy].IsLeaf());
+
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	--proxyCount;
+}
+
+bool AABBTree::MoveProxy(int proxy, const AABB& box)
+{
+	assert(nodes[proxy].IsLeaf());
+
+	if (nodes[proxy].box.Contains(box))
+		return false;
+
+	RemoveLeaf(proxy);
+
+	const float3 margin(AABB_TREE_MARGIN, AABB_TREE_MARGIN, AABB_TREE_MARGIN);
+	nodes[proxy].box.minPoint = box.minPoint - margin;
+	nodes[proxy].box.maxPoint = box.maxPoint + margin;
+
+	InsertLeaf(proxy);
+	return true;
+}
+
+void AABBTree::QueryFrustum(const Frustum& frustum, std::vector<GameObject*>& results) const
+{
+	if (root == AABB_TREE_NULL)
+		return;
+
+	Plane planes[6];
+	frustum.GetPlanes(planes);
+
+	// Every visit pops one entry and pushes at most two, never more than one per level and the root
+	assert(nodes[root].height <= AABB_TREE_MAX_HEIGHT);
+	int stack[AABB_TREE_MAX_HEIGHT + 1];
+	int count = 0;
+	stack[count++] = root;
+
+	while (count > 0)
+	{
+		const int index = stack[--count];
+		const Node& node = nodes[index];
+
+		// Planes point outwards: a box fully on the positive side of one of them is culled
+		const float3 center = node.box.CenterPoint();
+		const float3 extents = node.box.HalfSize();
+		bool outside = false;
+		bool inside = true;
+		for (int i = 0; i < 6 && !outside; ++i)
+		{
+			const float distance = planes[i].SignedDistance(center);
+			const float radius = extents.Dot(planes[i].normal.Abs());
+			if (distance - radius > 0.f)
+				outside = true;
+			else if (distance + radius > 0.f)
+				inside = false;
+		}
+
+		if (outside)
+			continue;
+
+		if (inside || node.IsLeaf())
+		{
+			// Subtrees fully inside need no more plane tests
+			CollectLeaves(index, results);
+			continue;
+		}
+
+		stack[count++] = node.left;
+		stack[count++] = node.right;
+	}
+}
+
+void AABBTree::QueryOverlap(const AABB& box, std::vector<GameObject*>& results) const
+{
+	if (root == AABB_TREE_NULL)
+		return;
+
+	assert(nodes[root].height <= AABB_TREE_MAX_HEIGHT);
+	int stack[AABB_TREE_MAX_HEIGHT + 1];
+	int count = 0;
+	stack[count++] = root;
+
+	while (count > 0)
+	{
+		const Node& node = nodes[stack[--count]];
+
+		if (!node.box.Intersects(box))
+			continue;
+
+		if (node.IsLeaf())
+		{
+			results.push_back(node.object);
+		}
+		else
+		{
+			stack[count++] = node.left;
+			stack[count++] = node.right;
+		}
+	}
+}
+
+void AABBTree::QueryRay(const LineSegment& ray, std::vector<AABBTreeRayHit>& results) const
+{
+	if (root == AABB_TREE_NULL)
+		return;
+
+	const size_t first = results.size();
+
+	assert(nodes[root].height <= AABB_TREE_MAX_HEIGHT);
+	int stack[AABB_TREE_MAX_HEIGHT + 1];
+	int count = 0;
+	stack[count++] = root;
+
+	while (count > 0)
+	{
+		const Node& node = nodes[stack[--count]];
+
+		float hitNear, hitFar;
+		if (!ray.Intersects(node.box, hitNear, hitFar))
+			continue;
+
+		if (node.IsLeaf())
+		{
+			AABBTreeRayHit hit;
+			hit.distance = hitNear;
+			hit.object = node.object;
+			results.push_back(hit);
+		}
+		else
+		{
+			stack[count++] = node.left;
+			stack[count++] = node.right;
+		}
+	}
+
+	std::sort(results.begin() + first, results.end(), [](const AABBTreeRayHit& a, const AABBTreeRayHit& b) { return a.distance < b.distance; });
+}
+
+int AABBTree::GetHeight() const
+{
+	return root == AABB_TREE_NULL ? 0 : nodes[root].height;
+}
+
+int AABBTree::AllocateNode()
+{
+	if (freeList == AABB_TREE_NULL)
+	{
+		Node node;
+		node.height = -1;
+		node.parent = AABB_TREE_NULL;
+		nodes.push_back(node);
+		freeList = (int)nodes.size() - 1;
+	}
+
+	const int index = freeList;
+	freeList = nodes[index].parent;
+
+	Node& node = nodes[index];
+	node.object = nullptr;
+	node.parent = AABB_TREE_NULL;
+	node.left = AABB_TREE_NULL;
+	node.right = AABB_TREE_NULL;
+	node.height = 0;
+	return index;
+}
+
+void AABBTree::FreeNode(int node)
+{
+	nodes[node].parent = freeList;
+	nodes[node].height = -1;
+	freeList = node;
+}
+
+void AABBTree::InsertLeaf(int leaf)
+{
+	if (root == AABB_TREE_NULL)
+	{
+		root = leaf;
+		nodes[root].parent = AABB_TREE_NULL;
+		return;
+	}
+
+	// Walk down picking the child that grows the least, stop when descending costs more than pairing here
+	const AABB leafBox = nodes[leaf].box;
+	int index = root;
+	while (!nodes[index].IsLeaf())
+	{
+		const int left = nodes[index].left;
+		const int right = nodes[index].right;
+
+		const float area = Perimeter(nodes[index].box);
+		const float combinedArea = Perimeter(Union(nodes[index].box, leafBox));
+
+		const float cost = 2.f * combinedArea;
+		const float inheritanceCost = 2.f * (combinedArea - area);
+
+		float costLeft = Perimeter(Union(leafBox, nodes[left].box)) + inheritanceCost;
+		if (!nodes[left].IsLeaf())
+			costLeft -= Perimeter(nodes[left].box);
+
+		float costRight = Perimeter(Union(leafBox, nodes[right].box)) + inheritanceCost;
+		if (!nodes[right].IsLeaf())
+			costRight -= Perimeter(nodes[right].box);
+
+		if (cost < costLeft && cost < costRight)
+			break;
+
+		index = costLeft < costRight ? left : right;
+	}
+
+	const int sibling = index;
+	const int oldParent = nodes[sibling].parent;
+	const int newParent = AllocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].box = Union(leafBox, nodes[sibling].box);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].left = sibling;
+	nodes[newParent].right = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	if (oldParent != AABB_TREE_NULL)
+	{
+		if (nodes[oldParent].left == sibling)
+			nodes[oldParent].left = newParent;
+		else
+			nodes[oldParent].right = newParent;
+	}
+	else
+	{
+		root = newParent;
+	}
+
+	Refit(nodes[leaf].parent);
+}
+
+void AABBTree::RemoveLeaf(int leaf)
+{
+	if (leaf == root)
+	{
+		root = AABB_TREE_NULL;
+		return;
+	}
+
+	const int parent = nodes[leaf].parent;
+	const int grandParent = nodes[parent].parent;
+	const int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+	if (grandParent != AABB_TREE_NULL)
+	{
+		// The sibling takes the place of the parent
+		if (nodes[grandParent].left == parent)
+			nodes[grandParent].left = sibling;
+		else
+			nodes[grandParent].right = sibling;
+		nodes[sibling].parent = grandParent;
+		FreeNode(parent);
+
+		Refit(grandParent);
+	}
+	else
+	{
+		root = sibling;
+		nodes[sibling].parent = AABB_TREE_NULL;
+		FreeNode(parent);
+	}
+}
+
+void AABBTree::Refit(int node)
+{
+	// Fix boxes and heights up to the root, rotating where the subtree got unbalanced
+	while (node != AABB_TREE_NULL)
+	{
+		node = Balance(node);
+
+		const int left = nodes[node].left;
+		const int right = nodes[node].right;
+
+		nodes[node].height = 1 + std::max(nodes[left].height, nodes[right].height);
+		nodes[node].box = Union(nodes[left].box, nodes[right].box);
+
+		node = nodes[node].parent;
+	}
+}
+
+int AABBTree::Balance(int a)
+{
+	Node& A = nodes[a];
+	if (A.IsLeaf() || A.height < 2)
+		return a;
+
+	const int b = A.left;
+	const int c = A.right;
+	const int balance = nodes[c].height - nodes[b].height;
+
+	// Rotate the taller child up
+	if (balance > 1 || balance < -1)
+	{
+		const int up = balance > 1 ? c : b; // Child that goes up
+		const int other = balance > 1 ? b : c;
+		Node& U = nodes[up];
+		const int f = U.left;
+		const int g = U.right;
+
+		U.left = a;
+		U.parent = A.parent;
+		A.parent = up;
+
+		if (U.parent != AABB_TREE_NULL)
+		{
+			if (nodes[U.parent].left == a)
+				nodes[U.parent].left = up;
+			else
+				nodes[U.parent].right = up;
+		}
+		else
+		{
+			root = up;
+		}
+
+		// The taller grandchild stays under the rotated node, the other one replaces it under A
+		const int keep = nodes[f].height > nodes[g].height ? f : g;
+		const int give = keep == f ? g : f;
+
+		U.right = keep;
+		if (balance > 1)
+			A.right = give;
+		else
+			A.left = give;
+		nodes[give].parent = a;
+
+		A.box = Union(nodes[other].box, nodes[give].box);
+		A.height = 1 + std::max(nodes[other].height, nodes[give].height);
+		U.box = Union(A.box, nodes[keep].box);
+		U.height = 1 + std::max(A.height, nodes[keep].height);
+
+		return up;
+	}
+
+	return a;
+}
+
+void AABBTree::CollectLeaves(int node, std::vector<GameObject*>& results) const
+{
+	int stack[AABB_TREE_MAX_HEIGHT + 1];
+	int count = 0;
+	stack[count++] = node;
+
+	while (count > 0)
+	{
+		const Node& current = nodes[stack[--count]];
+
+		if (current.IsLeaf())
+		{
+			results.push_back(current.object);
+		}
+		else
+		{
+			stack[count++] = current.left;
+			stack[count++] = current.right;
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Globals.h"
+#include "Geometry/AABB.h"
+#include "Geometry/Frustum.h"
+#include "Geometry/LineSegment.h"
+#include <vector>
+
+class GameObject;
+
+#define AABB_TREE_NULL -1
+#define AABB_TREE_MARGIN 0.1f // Leaves are fattened so small moves don't touch the tree
+#define AABB_TREE_MAX_HEIGHT 64 // Kept balanced, a taller tree would need billions of leaves
+
+struct AABBTreeRayHit
+{
+	float distance; // Normalized entry distance along the segment
+	GameObject* object;
+};
+
+// Dynamic bounding volume hierarchy over GameObject world AABBs (balanced like an AVL tree).
+// Leaves keep a fat box and are only reinserted when the object leaves it, queries cost O(log n).
+class AABBTree
+{
+public:
+	AABBTree();
+
+	int CreateProxy(const AABB& box, GameObject* object);
+	void DestroyProxy(int proxy);
+	bool MoveProxy(int proxy, const AABB& box); // Returns true if the leaf had to be reinserted
+
+	// Results are appended to the output vectors. Queries keep their state on the stack, any number
+	// of them may run at once as long as nothing modifies the tree.
+	void QueryFrustum(const Frustum& frustum, std::vector<GameObject*>& results) const;
+	void QueryOverlap(const AABB& box, std::vector<GameObject*>& results) const;
+	void QueryRay(const LineSegment& ray, std::vector<AABBTreeRayHit>& results) const; // Sorted by distance
+
+	inline const AABB& GetFatAABB(int proxy) const { return nodes[proxy].box; }
+	inline uint GetProxyCount() const { return proxyCount; }
+	int GetHeight() const;
+
+private:
+	struct Node
+	{
+		AABB box;
+		GameObject* object;
+		int parent; // Next free node when the node is unused
+		int left;
+		int right;
+		int height; // Leaf = 0, free = -1
+
+		inline bool IsLeaf() const { return left == AABB_TREE_NULL; }
+	};
+
+	int AllocateNode();
+	void FreeNode(int node);
+
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	int Balance(int node);
+	void Refit(int node);
+
+	void CollectLeaves(int node, std::vector<GameObject*>& results) const;
+
+private:
+	std::vector<Node> nodes;
+	int root = AABB_TREE_NULL;
+	int freeList = AABB_TREE_NULL;
+	uint proxyCount = 0;
+};
@@ -12,13 +12,49 @@
 #include "ModuleViewportFrameBuffer.h"
 #include "ModuleFileSystem.h"
 #include "ModuleTextures.h"
+#include "ModuleDebugDraw.h"
+#include "ModuleJobSystem.h"
+#include "Profiler.h"
+#include "FrameArena.h"
 #include "Globals.h"
 
+#include <string.h>
+#include <stdlib.h>
 
 
-Application::Application()
+
+Application::Application(int argc, char** argv)
 {
 	PERF_START(ptimer);
+
+	// Parsed before creating the modules, they pick their backends from it
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-headless") == 0)
+			headless = true;
+		else if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			maxFrames = strtoull(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "-profile") == 0 && i + 1 < argc)
+			profilePath = argv[++i];
+#ifdef FRAME_ARENA_COUNT_HEAP
+		else if (strcmp(argv[i], "-arena-check") == 0)
+			arenaCheck = true;
+#endif
+	}
+	if (headless)
+		LOG("Running headless%s", maxFrames > 0 ? "" : ", no frame limit given so close it from outside");
+#ifdef FRAME_ARENA_COUNT_HEAP
+	if (arenaCheck)
+		FrameArena::SetCountHeapAllocations(true);
+#endif
+
+	Profiler::Get().SetThreadName("Main");
+	if (!profilePath.empty())
+	{
+		LOG("Profiling every frame into %s", profilePath.c_str());
+		Profiler::Get().StartCapture();
+	}
+
 	window = new ModuleWindow(this);
 	input = new ModuleInput(this);
 	scene = new ModuleScene(this);
@@ -30,27 +66,92 @@ Application::Application()
 	import = new ModuleImport(this);
 	fileSystem = new ModuleFileSystem(this);
 	textures = new ModuleTextures(this);
+	debugDraw = new ModuleDebugDraw(this);
+	jobSystem = new ModuleJobSystem(this);
 
 	// The order of calls is very important!
-	// Modules will Init() Start() and Update in this order
-	// They will CleanUp() in reverse order
+	// Modules will Init(), Start() and CleanUp() in this order
+	// Updates keep this order only between modules that touch the same data, see below
 
 	// Main Modules
-	AddModule(fileSystem);
-	AddModule(window);
-	AddModule(camera);
-	AddModule(input);
-	AddModule(textures);
-	AddModule(import);
+	AddModule(jobSystem, "Job System");
+	AddModule(fileSystem, "File System");
+	AddModule(window, "Window");
+	AddModule(camera, "Camera");
+	AddModule(input, "Input");
+	AddModule(textures, "Textures");
+	AddModule(import, "Import");
 	
 	// Scenes
-	AddModule(viewportBufferGame);
-	AddModule(viewportBuffer);
-	AddModule(scene);
-	AddModule(editor);
+	AddModule(viewportBufferGame, "Game Viewport");
+	AddModule(viewportBuffer, "Scene Viewport");
+	AddModule(debugDraw, "Debug Draw");
+	AddModule(scene, "Scene");
+	AddModule(editor, "Editor");
 
 	// Renderer last!
-	AddModule(renderer3D);
+	AddModule(renderer3D, "Renderer");
+
+	// What every module touches during a frame. GL, SDL and ImGui work stays on the main thread,
+	// the rest runs on the workers alongside it: in PreUpdate the job stats and the debug draw clear
+	// overlap input and the texture uploads.
+	jobSystem->RunsOn(PHASE_PRE_UPDATE);
+	jobSystem->mainThreadOnly = false;
+
+	fileSystem->RunsOn(0);
+	window->RunsOn(0);
+
+	camera->RunsOn(PHASE_UPDATE);
+	camera->Reads(input);
+	camera->Reads(editor);
+	camera->Writes(debugDraw);
+
+	input->RunsOn(PHASE_PRE_UPDATE);
+
+	textures->RunsOn(PHASE_PRE_UPDATE);
+	textures->Writes(renderer3D); // Uploads
+
+	import->RunsOn(PHASE_UPDATE);
+	import->mainThreadOnly = false;
+
+	viewportBufferGame->RunsOn(PHASE_PRE_UPDATE | PHASE_POST_UPDATE);
+	viewportBufferGame->Writes(renderer3D);
+	viewportBuffer->RunsOn(PHASE_PRE_UPDATE | PHASE_POST_UPDATE);
+	viewportBuffer->Writes(renderer3D);
+
+	debugDraw->RunsOn(PHASE_PRE_UPDATE);
+	debugDraw->mainThreadOnly = false;
+
+	scene->RunsOn(PHASE_UPDATE);
+	scene->Reads(camera);
+	scene->Reads(editor);
+	scene->Reads(jobSystem);
+	scene->Writes(debugDraw);
+	scene->Writes(textures);
+	scene->Writes(viewportBufferGame);
+	scene->Writes(viewportBuffer);
+	scene->Writes(renderer3D);
+
+	// Windows and menus edit the scene and the cameras, the Configuration window draws the OnGui of
+	// every module that has one. Import is the only one left out, it keeps running on a worker.
+	editor->Reads(input);
+	editor->Reads(window);
+	editor->Writes(renderer3D);
+	editor->Writes(scene, PHASE_UPDATE);
+	editor->Writes(camera, PHASE_UPDATE);
+	editor->Writes(window, PHASE_UPDATE);
+	editor->Writes(input, PHASE_UPDATE);
+	editor->Writes(textures, PHASE_UPDATE);
+	editor->Writes(jobSystem, PHASE_UPDATE);
+	editor->Writes(debugDraw, PHASE_UPDATE);
+	editor->Writes(fileSystem, PHASE_UPDATE); // Scene save and load
+	editor->Reads(viewportBufferGame, PHASE_UPDATE);
+	editor->Reads(viewportBuffer, PHASE_UPDATE);
+
+	renderer3D->RunsOn(PHASE_PRE_UPDATE | PHASE_POST_UPDATE);
+	renderer3D->Writes(camera, PHASE_PRE_UPDATE);
+
+	moduleGraph.Build(modules);
 
 	//Control variable to close App
 	closeEngine = false;
@@ -127,11 +228,13 @@ void Application::LoadEngineConfig()
 // ---------------------------------------------
 void Application::PrepareUpdate()
 {
+	// Whatever the last frame allocated transiently is dropped here
+	FrameArena::ResetAll(frame_count);
 
 	frame_count++;
 	last_sec_frame_count++;
 
-	dt = (float)frame_time.ReadSec();
+	dt = (float)(frame_time.ReadMs() / 1000.0);
 	frame_time.Start();
 
 }
@@ -148,8 +251,16 @@ void Application::FinishUpdate()
 		last_sec_frame_count = 0;
 	}
 
-	uint32 last_frame_ms = frame_time.Read();
+	// Headless runs go as fast as they can
+	last_work_ms = frame_time.ReadMs();
+	if (!headless)
+		frameLimiter.Wait(frame_time, cap);
+
+	Profiler::Get().EndFrame(frame_count);
 
+	// The first frame also holds the startup, it would stay the worst frame of the history
+	if (frame_count > 1)
+		frameStats.AddFrame(frame_count, frame_time.ReadMs());
 }
 
 void Application::OnGui()
@@ -160,6 +271,9 @@ void Application::OnGui()
 	if (ImGui::CollapsingHeader("Hardware"))
 		DrawHardwareConsole();
 
+	if (ImGui::CollapsingHeader("Modules"))
+		moduleGraph.DrawTimings();
+
 	for (Module* module : modules)
 	{
 		module->OnGui();
@@ -173,22 +287,27 @@ update_status Application::Update()
 
 	update_status ret = UPDATE_CONTINUE;
 	PrepareUpdate();
-	
-	for (size_t i = 0; i < modules.size() && ret== UPDATE_CONTINUE; i++)
-	{
-		ret = modules[i]->PreUpdate(dt);
-	}
 
-	for (size_t i = 0; i < modules.size() && ret == UPDATE_CONTINUE; i++)
+	// Every phase ends before the next one starts, inside a phase the graph decides what overlaps
 	{
-		ret = modules[i]->Update(dt);
-	}
-
+		PROFILE_ZONE("Frame");
+		JobSystem& jobs = jobSystem->jobs;
+		{
+			PROFILE_ZONE("PreUpdate");
+			ret = moduleGraph.Run(PHASE_PRE_UPDATE, dt, jobs);
+		}
 
-	for (size_t i = 0; i < modules.size() && ret == UPDATE_CONTINUE; i++)
-	{
-		ret = modules[i]->PostUpdate(dt);
+		if (ret == UPDATE_CONTINUE)
+		{
+			PROFILE_ZONE("Update");
+			ret = moduleGraph.Run(PHASE_UPDATE, dt, jobs);
+		}
 
+		if (ret == UPDATE_CONTINUE)
+		{
+			PROFILE_ZONE("PostUpdate");
+			ret = moduleGraph.Run(PHASE_POST_UPDATE, dt, jobs);
+		}
 	}
 
 	// If main menu bar exit button pressed changes closeEngine bool to true and closes App
@@ -196,6 +315,12 @@ update_status Application::Update()
 
 	FinishUpdate();
 
+	if (maxFrames > 0 && frame_count >= maxFrames && ret == UPDATE_CONTINUE)
+	{
+		LOG("Ran the requested %llu frames in %.2f s", maxFrames, startup_time.ReadSec());
+		ret = UPDATE_STOP;
+	}
+
 	return ret;
 }
 
@@ -204,14 +329,48 @@ update_status Application::Update()
 bool Application::CleanUp()
 {
 	bool ret = true;
+
+	// Checked before anything else allocates. Frames were accounted up to the start of the last one,
+	// which also logs the end of the run and is left out.
+	bool arenaSteady = true;
+#ifdef FRAME_ARENA_COUNT_HEAP
+	if (arenaCheck)
+	{
+		FrameArena::SetCountHeapAllocations(false);
+
+		FrameArenaStats stats;
+		FrameArena::GetStats(stats);
+		if (FrameArena::IsSteady(frame_count > 0 ? frame_count - 1 : 0))
+		{
+			LOG("Frame arena steady after the warm-up: no heap allocation, %d threads, %d KB of %d KB used", stats.threads, (uint)(stats.usedBytes / 1024), (uint)(stats.capacityBytes / 1024));
+		}
+		else
+		{
+			LOG("Frame arena check failed: arena grew at frame %llu, heap allocated at frame %llu, of %llu frames with a warm-up of %d",
+				stats.lastGrowthFrame, stats.lastHeapFrame, frame_count, FRAME_ARENA_WARMUP_FRAMES);
+			arenaSteady = false;
+		}
+	}
+#endif
+
 	SaveEngineConfig();
 
+	// Written before the file system goes away
+	if (!profilePath.empty())
+	{
+		Profiler::Get().StopCapture();
+		Profiler::Get().ExportChromeTrace(profilePath.c_str());
+	}
+
 	for (size_t i = 0; i < modules.size() && ret == true; i++)
 	{
 		ret = modules[i]->CleanUp();
 	}
 
-	return ret;
+	// Workers are joined by now
+	FrameArena::ReleaseAll();
+
+	return ret && arenaSteady;
 }
 
 void Application::SaveEngineConfig()
@@ -236,8 +395,9 @@ void Application::SaveEngineConfig()
 	}
 }
 
-void Application::AddModule(Module* mod)
+void Application::AddModule(Module* mod, const char* name)
 {
+	mod->SetName(name);
 	modules.push_back(mod);
 }
 
@@ -250,33 +410,31 @@ void Application::DrawFPSDiagram() {
 
 	ImGui::InputText("App Name", TITLE, 20);
 	ImGui::InputText("Organization", ORGANITZATION, 20);
-	ImGui::SliderInt("Framerate", &cap, -1, 120);
+	ImGui::SliderInt("Framerate", &cap, 0, 240, cap > 0 ? "%d" : "No limit");
 
-	if (fps_log.size() != 30)
-	{
-		fps_log.push_back(fps);
-		ms_log.push_back(dt * 1000);
-	}
-	else
-	{
-		fps_log.erase(fps_log.begin());
-		fps_log.push_back(fps);
-		ms_log.erase(ms_log.begin());
-		ms_log.push_back(dt * 1000);
-	}
+	FramePercentiles percentiles;
+	frameStats.GetPercentiles(percentiles);
+
+	char title[40];
+	sprintf_s(title, 40, "Framerate %.1f  Milliseconds %.2f", fps, frameStats.GetLastMs());
+	const float scale = percentiles.max > 33.3 ? (float)percentiles.max : 33.3f;
+	ImGui::PlotLines("##frametimes", frameStats.GetHistory(), frameStats.GetHistoryCount(), frameStats.GetHistoryOffset(), title, 0.0f, scale, ImVec2(310, 100));
+
+	ImGui::Text("Last %d frames: p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms", percentiles.count, percentiles.p50, percentiles.p95, percentiles.p99, percentiles.max);
+	ImGui::Text("Work %.2f ms, limiter wait %.2f ms (spin %.2f ms)", last_work_ms, frameLimiter.GetLastWaitMs(), frameLimiter.GetSpinMarginMs());
 
-	char title[25];
-	sprintf_s(title, 25, "Framerate %.1f", fps_log[fps_log.size() - 1]);
-	ImGui::PlotHistogram("##framerate", &fps_log[0], fps_log.size(), 0, title, 0.0f, 100.0f, ImVec2(310, 100));
-	sprintf_s(title, 25, "Milliseconds %.1f", ms_log[ms_log.size() - 1]);
-	ImGui::PlotHistogram("##framerate", &ms_log[0], ms_log.size(), 0, title, 0.0f, 100.0f, ImVec2(310, 100));
+	FrameArenaStats arena;
+	FrameArena::GetStats(arena);
+	ImGui::Text("Frame arena %d KB of %d KB, %d threads, last grew at frame %llu", (uint)(arena.usedBytes / 1024), (uint)(arena.capacityBytes / 1024), arena.threads, arena.lastGrowthFrame);
+	if (arenaCheck)
+		ImGui::Text("Heap allocations %llu last frame, last at frame %llu", arena.heapAllocations, arena.lastHeapFrame);
+
+	ImGui::SliderFloat("Hitch threshold (ms)", &frameStats.hitchThresholdMs, 5.f, 200.f);
+	DrawHitches();
 
 	if (ImGui::Checkbox("VSYNC:", &App->renderer3D->vsyncActive)) {
 
-		if (App->renderer3D->vsyncActive)
-			SDL_GL_SetSwapInterval(1);
-		else
-			SDL_GL_SetSwapInterval(0);
+		App->renderer3D->backend->SetVSync(App->renderer3D->vsyncActive);
 
 	}
 
@@ -286,6 +444,39 @@ void Application::DrawFPSDiagram() {
 
 
 }
+void Application::DrawHitches()
+{
+	if (!ImGui::TreeNode("Hitches", "Hitches (%d)", frameStats.GetHitchCount()))
+		return;
+
+	FrameVector<const FrameHitch*> hitches;
+	frameStats.GetHitches(hitches);
+
+	if (!Profiler::IsRecording())
+		ImGui::TextDisabled("Record in the profiler to keep the zones of every hitch");
+
+	for (const FrameHitch* hitch : hitches)
+	{
+		if (!ImGui::TreeNode(hitch, "Frame %llu: %.2f ms, median %.2f ms", hitch->frame, hitch->ms, hitch->medianMs))
+			continue;
+
+		// The outer zones taking a visible share are enough to tell which module or step took the time
+		for (const ProfileEvent& zone : hitch->zones)
+		{
+			const double ms = Profiler::TicksToMs(zone.end - zone.start);
+			if (zone.depth > 2 || ms < hitch->ms * 0.01)
+				continue;
+			ImGui::Text("%*s%s %s: %.3f ms", zone.depth * 2, "", Profiler::Get().GetThreadName(zone.thread).c_str(), zone.name, ms);
+		}
+		ImGui::TreePop();
+	}
+
+	if (!hitches.empty() && ImGui::Button("Clear Hitches"))
+		frameStats.ClearHitches();
+
+	ImGui::TreePop();
+}
+
 void Application::DrawHardwareConsole() {
 
 	ImGui::Text("SDL Version: ");
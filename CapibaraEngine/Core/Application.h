@@ -7,6 +7,8 @@
 #include "Globals.h"
 #include "Timer.h"
 #include "PerfTimer.h"
+#include "ModuleGraph.h"
+#include "FrameTiming.h"
 
 //Forward declarations
 
@@ -21,6 +23,8 @@ class ModuleViewportFrameBuffer;
 class ModuleImport;
 class ModuleFileSystem;
 class ModuleTextures;
+class ModuleDebugDraw;
+class ModuleJobSystem;
 
 class Application
 {
@@ -37,8 +41,10 @@ public:
 	ModuleImport* import { nullptr };
 	ModuleFileSystem* fileSystem { nullptr };
 	ModuleTextures* textures { nullptr };
+	ModuleDebugDraw* debugDraw { nullptr };
+	ModuleJobSystem* jobSystem { nullptr };
 
-	Application();
+	Application(int argc = 0, char** argv = nullptr);
 	~Application();
 
 	bool Init();
@@ -50,10 +56,11 @@ public:
 	void SaveEngineConfig();
 
 	void DrawFPSDiagram();
+	void DrawHitches();
 	void DrawHardwareConsole();
 
 
-	void AddModule(Module* mod);
+	void AddModule(Module* mod, const char* name);
 	void PrepareUpdate();
 	void FinishUpdate();
 
@@ -65,28 +72,38 @@ public:
 	//Fps core
 	float				fps;
 	float				dt;
-	int					cap;
+	int					cap; // Frames per second, no limit at 0 or less
 	PerfTimer			ptimer;
 	Timer				ms_timer;
-	Timer				frame_time;
+	PerfTimer			frame_time;
 	uint64				frame_count = 0;
 	Timer				startup_time;
 	Timer				last_sec_frame_time;
 	uint32				last_sec_frame_count = 0;
 	uint32				prev_last_sec_frame_count = 0;
-	
+	double				last_work_ms = 0.0; // Frame time before the limiter waits
 
-	std::vector<float> fps_log;
-	std::vector<float> ms_log;
+	FrameStats			frameStats;
+	FrameLimiter		frameLimiter;
 
 	//Engine configuration
 	bool closeEngine;
 	bool vsync;
 
+	// Command line: -headless runs without window or GPU, -frames N quits after N frames,
+	// -profile file captures every frame and writes it as a Chrome trace on exit,
+	// -arena-check counts heap allocations and fails the exit if a frame after the warm-up made any,
+	// only in builds with FRAME_ARENA_COUNT_HEAP
+	bool headless = false;
+	uint64 maxFrames = 0;
+	std::string profilePath;
+	bool arenaCheck = false;
+
 
 
 private: 
 	std::vector<Module*> modules;
+	ModuleGraph moduleGraph;
 
 };
 
@@ -4,16 +4,21 @@
 #include <vector>
 #include <string>
 #include "GameObject.h"
+#include "ComponentPool.h"
 
 class Component 
 {
 public:
-	Component(GameObject* parent) : owner(parent)
+	Component(GameObject* parent, ComponentType type) : owner(parent), type(type)
 	{
+		ComponentPool::Get(type).Add(this);
 		if (parent)
 			parent->AddComponent(this);
 	};
-	virtual ~Component() {};
+	virtual ~Component() 
+	{
+		ComponentPool::Get(type).Remove(this);
+	};
 
 	virtual bool Update(float dt) {
 		return true;
@@ -23,6 +28,8 @@ public:
 	virtual bool Disable() { return active == false; };
 	virtual void OnGui() { }
 
+	inline ComponentType GetType() const { return type; }
+
 	// Scene Serialization
 	virtual void Save(JSONWriter& writer) {}
 	virtual void Load(const JSONReader& reader) {}
@@ -31,4 +38,11 @@ public:
 
 	GameObject* owner = nullptr;
 	bool active = true;
+
+private:
+
+	friend class ComponentPool;
+
+	ComponentType type;
+	uint poolIndex = 0;
 };
\ No newline at end of file
@@ -3,10 +3,11 @@
 #include "GameObject.h"
 #include "ModuleCamera3D.h"
 #include "ComponentTransform.h"
-#include "SDL/include/SDL_opengl.h"
+#include "ModuleRenderer3D.h"
+#include "ModuleDebugDraw.h"
 
 
-ComponentCamera::ComponentCamera(GameObject* parent) : Component(parent)
+ComponentCamera::ComponentCamera(GameObject* parent) : Component(parent, TYPE)
 {
 	right = float3(1.0f, 0.0f, 0.0f);
 	up = float3(0.0f, 1.0f, 0.0f);
@@ -84,24 +85,12 @@ void ComponentCamera::DrawCamera()
 	CalculateViewMatrix();
 
 	App->viewportBufferGame->PreUpdate(App->dt);
-	glMatrixMode(GL_PROJECTION);
-	glLoadMatrixf(cameraFrustum.ProjectionMatrix().Transposed().ptr());
-	glMatrixMode(GL_MODELVIEW);
-	glLoadMatrixf(viewMatrix.Transposed().ptr());
+	App->renderer3D->backend->SetCamera(viewMatrix, cameraFrustum.ProjectionMatrix());
 }
 
 void ComponentCamera::DrawCameraBoundaries()
 {
-	static float3 cornerPoints[8];
-	cameraFrustum.GetCornerPoints(cornerPoints);
-
-	int frustumPoints[FRUSTUM_MAX_POINTS] = FRUSTUM_POINTS;
-
-	glBegin(GL_LINES);
-	for (uint i = 0; i < FRUSTUM_MAX_POINTS; ++i)
-		glVertex3fv(&cornerPoints[frustumPoints[i]].x);
-
-	glEnd();
+	App->debugDraw->Frustum(cameraFrustum, White);
 }
 
 void ComponentCamera::Save(JSONWriter& writer)
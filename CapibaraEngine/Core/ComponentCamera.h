@@ -6,14 +6,15 @@
 #include "Geometry/Frustum.h"
 #include "Globals.h"
 #include "ModuleViewportFrameBuffer.h"
+#include "RenderView.h"
 #include "ImGui/imgui.h"
 
-#define FRUSTUM_POINTS { 0,2, 2,6, 6,4, 4,0, 0,1, 1,3, 3,2, 3,7, 7,5, 5,1, 6,7, 5,4 }
-#define FRUSTUM_MAX_POINTS 24
 
 class ComponentCamera : public Component
 {
 public:
+	COMPONENT_TYPE(ComponentType::CAMERA)
+
 	ComponentCamera(GameObject* parent);
 	~ComponentCamera();
 
@@ -37,4 +38,6 @@ public:
 	float nearPlaneDistance = 0.1f;
 	float farPlaneDistance = 250.f;
 	bool projectionIsDirty = false;
+
+	RenderView view;
 };
\ No newline at end of file
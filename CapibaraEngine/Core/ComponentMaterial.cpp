@@ -4,16 +4,37 @@
 #include "ImGui/imgui.h"
 #include "ComponentMaterial.h"
 
-ComponentMaterial::ComponentMaterial(GameObject* parent) : Component(parent) {}
+ComponentMaterial::ComponentMaterial(GameObject* parent) : Component(parent, TYPE) {}
 
 void ComponentMaterial::SetTexture(const TextureObject& texture)
 {
+	pendingTexture.clear();
 	textureName = texture.name;
 	textureId = texture.id;
 	width = texture.width;
 	height = texture.height;
 }
 
+void ComponentMaterial::SetTextureAsync(const std::string& path)
+{
+	const TextureObject& texture = App->textures->LoadAsync(path);
+	SetTexture(texture);
+
+	if (texture.name != path)
+		pendingTexture = path;
+}
+
+void ComponentMaterial::ResolvePendingTexture()
+{
+	if (!pendingTexture.empty())
+	{
+		if (App->textures->Find(pendingTexture))
+			SetTexture(App->textures->Get(pendingTexture));
+		else if (!App->textures->IsPending(pendingTexture))
+			pendingTexture.clear(); //decoding failed, keep the placeholder
+	}
+}
+
 void ComponentMaterial::OnGui()
 {
 	if (ImGui::CollapsingHeader("Material"))
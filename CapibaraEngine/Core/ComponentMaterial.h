@@ -6,9 +6,13 @@ struct TextureObject;
 class ComponentMaterial : public Component 
 {
 public:
+	COMPONENT_TYPE(ComponentType::MATERIAL)
+
 	ComponentMaterial(GameObject* parent);
 
 	void SetTexture(const TextureObject& texture);
+	void SetTextureAsync(const std::string& path); //shows a placeholder until the texture is streamed in
+	void ResolvePendingTexture(); //swaps the placeholder once the streamed texture is uploaded
 	void OnGui() override;
 	inline uint GetTextureId() const { return textureId; }
 
@@ -18,5 +22,6 @@ public:
 
 private:
 	std::string textureName;
+	std::string pendingTexture;
 	uint textureId = 0, width = 0, height = 0;
 };
\ No newline at end of file
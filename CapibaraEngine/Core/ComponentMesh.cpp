@@ -1,34 +1,42 @@
 #include "ComponentMesh.h"
 
-#include "glew.h"
-#include "SDL/include/SDL_opengl.h"
 #include "Application.h"
 #include "ModuleRenderer3D.h"
 #include "ModuleEditor.h"
+#include "ModuleScene.h"
+#include "ModuleCamera3D.h"
+#include "ModuleDebugDraw.h"
 #include "ComponentMaterial.h"
 #include "ComponentTransform.h"
+#include "VertexEncoding.h"
+#include "MeshSimplifier.h"
+#include "Math/MathConstants.h"
 #include "GameObject.h"
 #include "ImGui/imgui.h"
 #include "MathGeoLib/include/Geometry/Plane.h"
 #include "Geometry/Sphere.h"
 #include "par_shapes.h"
 
-ComponentMesh::ComponentMesh(GameObject* parent) : Component(parent) {}
+ComponentMesh::ComponentMesh(GameObject* parent) : Component(parent, TYPE) {}
 
-ComponentMesh::ComponentMesh(GameObject* parent, Shape shape) : Component(parent)
+ComponentMesh::ComponentMesh(GameObject* parent, Shape shape) : Component(parent, TYPE)
 {
 	switch (shape)
 	{
 	case Shape::CUBE:
+		geometryKey = "Primitive/Cube";
 		CopyParMesh(par_shapes_create_cube());		
 		break;
 	case Shape::CYLINDER:
+		geometryKey = "Primitive/Cylinder";
 		CopyParMesh(par_shapes_create_cylinder(20, 20));
 		break;
 	case Shape::SPHERE:
+		geometryKey = "Primitive/Sphere";
 		CopyParMesh(par_shapes_create_parametric_sphere(20, 20));
 		break;
 	case Shape::PLANE:
+		geometryKey = "Primitive/Plane";
 		CopyParMesh(par_shapes_create_plane(20, 20));
 		break;
 	}
@@ -36,9 +44,19 @@ ComponentMesh::ComponentMesh(GameObject* parent, Shape shape) : Component(parent
 
 ComponentMesh::~ComponentMesh()
 {
-	vertexBufferId ? glDeleteBuffers(1, &vertexBufferId) : 0;
-	textureBufferId ? glDeleteBuffers(1, &textureBufferId) : 0;
-	indexBufferId ? glDeleteBuffers(1, &indexBufferId) : 0;
+	if (!geometryKey.empty() && vertexBufferId != 0)
+		App->renderer3D->geometryCache.Release(geometryKey, App->renderer3D->backend);
+	else
+	{
+		App->renderer3D->backend->DeleteVertexArray(vertexArrayId);
+		App->renderer3D->backend->DeleteBuffer(vertexBufferId);
+		App->renderer3D->backend->DeleteBuffer(indexBufferId);
+	}
+	App->renderer3D->backend->DeleteBuffer(vertexNormalLines);
+	App->renderer3D->backend->DeleteBuffer(faceNormalLines);
+
+	if (treeProxy != AABB_TREE_NULL)
+		App->scene->sceneTree.DestroyProxy(treeProxy);
 }
 
 void ComponentMesh::CopyParMesh(par_shapes_mesh* parMesh)
@@ -63,43 +81,120 @@ void ComponentMesh::CopyParMesh(par_shapes_mesh* parMesh)
 
 	par_shapes_free_mesh(parMesh);
 
+	Optimize();
+	GenerateLods();
 	GenerateBuffers();
 	ComputeNormals();
 	GenerateBounds();
+	bvh.Build(vertices, indices);
+	UpdateWorldBounds();
 }
 
 
 void ComponentMesh::GenerateBuffers()
 {
 	
-	//-- Generate Vertex
-	vertexBufferId = 0;
-	glGenBuffers(1, &vertexBufferId);
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float3) * numVertices, &vertices[0], GL_STATIC_DRAW);
-
-	//-- Generate Index
-	indexBufferId = 0;
-	glGenBuffers(1, &indexBufferId);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferId);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint) * numIndices, &indices[0], GL_STATIC_DRAW);
-
-	//-- Generate Texture_Buffers
-	if (texCoords.size() != 0)
+	RenderBackend* backend = App->renderer3D->backend;
+
+	// Another copy of this geometry is already on the GPU
+	SharedGeometry shared;
+	if (!geometryKey.empty() && App->renderer3D->geometryCache.Acquire(geometryKey, shared))
+	{
+		vertexBufferId = shared.vertexBuffer;
+		indexBufferId = shared.indexBuffer;
+		vertexArrayId = shared.vertexArray;
+		indexType = shared.indexType;
+		gpuBytes = 0;
+		return;
+	}
+
+	// Position, normal and uv of a vertex side by side, fetched together by the GPU. Normals and uvs
+	// are packed into 32 bits each when the backend can read them
+	const bool packNormals = backend->SupportsVertexType(VertexType::INT_2_10_10_10);
+	const bool packTexCoords = backend->SupportsVertexType(VertexType::HALF_FLOAT);
+
+	VertexFormat format;
+	format.Add(VertexAttribute::POSITION, 3);
+	if (normals.size() == numVertices)
+		format.Add(VertexAttribute::NORMAL, 3, packNormals ? VertexType::INT_2_10_10_10 : VertexType::FLOAT);
+	if (texCoords.size() == numVertices)
+		format.Add(VertexAttribute::TEXCOORD, 2, packTexCoords ? VertexType::HALF_FLOAT : VertexType::FLOAT);
+
+	std::vector<char> interleaved(format.stride * numVertices);
+	for (uint i = 0; i < numVertices; ++i)
+	{
+		char* vertex = &interleaved[i * format.stride];
+		memcpy(vertex + format.Get(VertexAttribute::POSITION).offset, &vertices[i], sizeof(float3));
+
+		if (format.Has(VertexAttribute::NORMAL))
+		{
+			char* normal = vertex + format.Get(VertexAttribute::NORMAL).offset;
+			if (packNormals)
+			{
+				const uint packed = VertexEncoding::PackNormal(normals[i]);
+				memcpy(normal, &packed, sizeof(packed));
+			}
+			else
+				memcpy(normal, &normals[i], sizeof(float3));
+		}
+
+		if (format.Has(VertexAttribute::TEXCOORD))
+		{
+			char* texCoord = vertex + format.Get(VertexAttribute::TEXCOORD).offset;
+			if (packTexCoords)
+			{
+				const uint packed = VertexEncoding::PackTexCoord(texCoords[i]);
+				memcpy(texCoord, &packed, sizeof(packed));
+			}
+			else
+				memcpy(texCoord, &texCoords[i], sizeof(float2));
+		}
+	}
+
+	vertexBufferId = backend->CreateBuffer(BufferType::VERTEX, &interleaved[0], (uint)interleaved.size());
+	gpuBytes = (uint)interleaved.size();
+
+	// Small meshes, which is most of them, only need half the index bytes. The simplified levels
+	// follow the full mesh in the same buffer
+	const uint totalIndices = numIndices + (uint)lodIndices.size();
+	indexType = numVertices <= VertexEncoding::MAX_SHORT_INDEX_VERTICES ? IndexType::UINT16 : IndexType::UINT32;
+	if (indexType == IndexType::UINT16)
 	{
-		textureBufferId = 0;
-		glGenBuffers(1, &textureBufferId);
-		glBindBuffer(GL_ARRAY_BUFFER, textureBufferId);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(float2) * texCoords.size(), &texCoords[0], GL_STATIC_DRAW);
+		std::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+		shortIndices.insert(shortIndices.end(), lodIndices.begin(), lodIndices.end());
+		indexBufferId = backend->CreateBuffer(BufferType::INDEX, &shortIndices[0], sizeof(unsigned short) * totalIndices);
+		gpuBytes += sizeof(unsigned short) * totalIndices;
 	}
+	else
+	{
+		std::vector<uint> allIndices(indices);
+		allIndices.insert(allIndices.end(), lodIndices.begin(), lodIndices.end());
+		indexBufferId = backend->CreateBuffer(BufferType::INDEX, &allIndices[0], sizeof(uint) * totalIndices);
+		gpuBytes += sizeof(uint) * totalIndices;
+	}
+
 	if (vertexBufferId == 0 || indexBufferId == 0)
+	{
 		LOG("Error creating mesh on gameobject %s", owner->name.c_str());
+		return;
+	}
+
+	vertexArrayId = backend->CreateVertexArray(vertexBufferId, indexBufferId, format);
+
+	if (!geometryKey.empty())
+	{
+		shared.vertexBuffer = vertexBufferId;
+		shared.indexBuffer = indexBufferId;
+		shared.vertexArray = vertexArrayId;
+		shared.indexType = indexType;
+		App->renderer3D->geometryCache.Add(geometryKey, shared);
+	}
 }
 
 void ComponentMesh::ComputeNormals()
 {
 
-	numNormalFaces = numIndices * 3;
+	numNormalFaces = numIndices / 3;
 	faceNormals.resize(numNormalFaces);
 	faceCenters.resize(numNormalFaces);
 
@@ -114,7 +209,6 @@ void ComponentMesh::ComputeNormals()
 		const float3 faceCenter = (vertices[indices[i]] + vertices[indices[i + 1]] + vertices[indices[i + 2]]) / 3.f;
 		faceCenters[i / 3] = faceCenter;
 	}
-	int kk = 0;
 }
 
 void ComponentMesh::GenerateBounds()
@@ -129,173 +223,172 @@ void ComponentMesh::GenerateBounds()
 
 	radius = sphere.r;
 	centerPoint = sphere.pos;
+}
 
-	owner->globalOBB = GetAABB();
-	owner->globalOBB.Transform(owner->transform->transformMatrixLocal);
+void ComponentMesh::Optimize()
+{
+	sourceCacheStats = MeshOptimizer::AnalyzeVertexCache(indices, numVertices);
 
-	owner->globalAABB.SetNegativeInfinity();
-	owner->globalAABB.Enclose(owner->globalOBB);
+	MeshOptimizer::OptimizeVertexCache(indices, numVertices);
+	MeshOptimizer::OptimizeOverdraw(indices, vertices);
+
+	std::vector<uint> remap;
+	MeshOptimizer::OptimizeVertexFetch(indices, numVertices, remap);
+	MeshOptimizer::RemapVertices(vertices, remap);
+	MeshOptimizer::RemapVertices(normals, remap);
+	MeshOptimizer::RemapVertices(texCoords, remap);
+
+	cacheStats = MeshOptimizer::AnalyzeVertexCache(indices, numVertices);
 }
 
-void ComponentMesh::DrawNormals() const
+void ComponentMesh::GenerateLods()
 {
-	if (drawFaceNormals)
-	{
-		for (size_t i = 0; i < faceNormals.size(); ++i)
-		{
-			glColor3f(0.f, 0.f, 1.f);
-			glBegin(GL_LINES);			
-			const float3 faceCenter = owner->transform->transformMatrix.TransformPos(faceCenters[i]);
-			const float3 faceNormalPoint = faceCenter + faceNormals[i] * normalScale;
-			glVertex3f(faceCenter.x, faceCenter.y, faceCenter.z);
-			glVertex3f(faceNormalPoint.x, faceNormalPoint.y, faceNormalPoint.z);
-			glEnd();
-		}
-	}
-	if (drawVertexNormals)
+	lods.clear();
+	lodIndices.clear();
+
+	MeshLod full;
+	full.firstIndex = 0;
+	full.numIndices = numIndices;
+	full.error = 0.f;
+	lods.push_back(full);
+
+	// Every level halves the previous one, errors add up since each starts from the level before
+	std::vector<uint> source = indices, simplified;
+	while (lods.size() < MESH_LOD_MAX && source.size() / 3 > MESH_LOD_MIN_TRIANGLES)
 	{
-		for (size_t i = 0; i < normals.size(); ++i)
-		{
-			glColor3f(1.f, 0.f, 0.f);
-			glBegin(GL_LINES);
-			const float3 vertexPos = owner->transform->transformMatrix.TransformPos(vertices[i]);
-			const float3 vertexNormalPoint = vertexPos + normals[i] * normalScale;
-			glVertex3f(vertexPos.x, vertexPos.y, vertexPos.z);
-			glVertex3f(vertexNormalPoint.x, vertexNormalPoint.y, vertexNormalPoint.z);
-			glEnd();
-		}
+		const uint target = (uint)(source.size() / 6) * 3;
+		const float error = MeshSimplifier::Simplify(vertices, source, target, MESH_LOD_MAX_ERROR - lods.back().error, simplified);
+		if (simplified.empty() || simplified.size() > source.size() * MESH_LOD_MIN_REDUCTION)
+			break;
+
+		// Collapses leave holes in the triangle order, levels get the same treatment as the full mesh
+		MeshOptimizer::OptimizeVertexCache(simplified, numVertices);
+		MeshOptimizer::OptimizeOverdraw(simplified, vertices);
+
+		MeshLod lod;
+		lod.firstIndex = numIndices + (uint)lodIndices.size();
+		lod.numIndices = (uint)simplified.size();
+		lod.error = lods.back().error + error;
+		lods.push_back(lod);
+
+		lodIndices.insert(lodIndices.end(), simplified.begin(), simplified.end());
+		source.swap(simplified);
 	}
 }
 
-float3 ComponentMesh::GetCenterPointInWorldCoords() const
+uint ComponentMesh::SelectLod(float screenSize, uint currentLod) const
 {
-	return owner->transform->transformMatrix.TransformPos(centerPoint);
+	// A level is good enough while its error, projected with the bounding sphere, stays under about a pixel
+	auto threshold = [this](uint level)
+	{
+		return lods[level].error > 0.f ? MESH_LOD_SCREEN_ERROR / (2.f * lods[level].error) : FLOAT_INF;
+	};
+
+	// Coarser only once well under the next threshold, finer only once well over the current one
+	uint level = currentLod < lods.size() ? currentLod : 0;
+	while (level + 1 < lods.size() && screenSize < threshold(level + 1) * (1.f - MESH_LOD_HYSTERESIS))
+		++level;
+	while (level > 0 && screenSize > threshold(level) * (1.f + MESH_LOD_HYSTERESIS))
+		--level;
+
+	return level;
 }
 
-void ComponentMesh::DrawBoundingBox(float3* points, float3 color) const
+void ComponentMesh::UpdateWorldBounds()
 {
-	glColor3fv(&color.x);
-	glLineWidth(2.f);
-	glBegin(GL_LINES);
+	if (vertices.empty())
+		return;
 
-	std::vector<int> ind =
-	{
-		0,2,2,6,6,4,4,0,
-		0,1,1,3,3,2,4,5,
-		6,7,5,7,3,7,1,5,
-	};
-	for (const auto& i : ind)
-	{
-		glVertex3fv(&points[i].x);
-	}
+	owner->globalOBB = GetAABB();
+	owner->globalOBB.Transform(owner->transform->GetGlobalMatrix());
+
+	owner->globalAABB.SetNegativeInfinity();
+	owner->globalAABB.Enclose(owner->globalOBB);
 
-	glEnd();
-	glLineWidth(1.f);
-	glColor3f(1.f, 1.f, 1.f);
+	if (treeProxy == AABB_TREE_NULL)
+		treeProxy = App->scene->sceneTree.CreateProxy(owner->globalAABB, owner);
+	else
+		App->scene->sceneTree.MoveProxy(treeProxy, owner->globalAABB);
 }
 
-bool ComponentMesh::GameCamera(Frustum* frustumCam)
+void ComponentMesh::DrawNormals()
 {
-	float3 obb[8];
-	Plane frustum[6];
-	int total = 0;
-
-	frustumCam->GetPlanes(frustum);
-	owner->globalAABB.GetCornerPoints(obb);
+	RenderBackend* backend = App->renderer3D->backend;
 
-	for (int i = 0; i < 6; i++)
+	// Lines live on the GPU in local space, the mesh transform places them like the mesh itself
+	if (normalLinesScale != normalScale)
 	{
-		int count = 8;
-		int points = 1;
+		backend->DeleteBuffer(vertexNormalLines);
+		backend->DeleteBuffer(faceNormalLines);
+		normalLinesScale = normalScale;
+	}
 
-		for (int b = 0; b < 8; b++)
+	std::vector<float3> lines;
+	if (drawFaceNormals && faceNormalLines == 0 && !faceNormals.empty())
+	{
+		lines.reserve(faceNormals.size() * 2);
+		for (size_t i = 0; i < faceNormals.size(); ++i)
 		{
-			if (frustum[i].IsOnPositiveSide(obb[b]))
-			{
-				points = 0;
-				--count;
-			}
-
-			if (count <= 0) return false;
-
-			total += points;
+			lines.push_back(faceCenters[i]);
+			lines.push_back(faceCenters[i] + faceNormals[i] * normalScale);
 		}
+		faceNormalLines = backend->CreateBuffer(BufferType::VERTEX, &lines[0], (uint)(lines.size() * sizeof(float3)));
 	}
-
-	if (total >= 6) return true;
-
-	return true;
-}
-
-bool ComponentMesh::Update(float dt)
-{
-	if (GameCamera(&App->editor->cameraGame->cameraFrustum))
+	if (drawVertexNormals && vertexNormalLines == 0 && !normals.empty())
 	{
-		drawWireframe || App->renderer3D->wireframeMode ? glPolygonMode(GL_FRONT_AND_BACK, GL_LINE) : glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-		glBindTexture(GL_TEXTURE_2D, 0);
-
-		//--Enable States--//
-		glEnableClientState(GL_VERTEX_ARRAY);
-
-		if (this->textureBufferId)
+		lines.clear();
+		lines.reserve(normals.size() * 2);
+		for (size_t i = 0; i < normals.size(); ++i)
 		{
-			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-			glBindBuffer(GL_ARRAY_BUFFER, this->textureBufferId);
-			glTexCoordPointer(2, GL_FLOAT, 0, NULL);
+			lines.push_back(vertices[i]);
+			lines.push_back(vertices[i] + normals[i] * normalScale);
 		}
+		vertexNormalLines = backend->CreateBuffer(BufferType::VERTEX, &lines[0], (uint)(lines.size() * sizeof(float3)));
+	}
 
-		glBindBuffer(GL_ARRAY_BUFFER, this->vertexBufferId);
-		glVertexPointer(3, GL_FLOAT, 0, NULL);
+	const float4x4& globalMatrix = owner->transform->GetGlobalMatrix();
+	if (drawFaceNormals)
+		App->debugDraw->LineBuffer(faceNormalLines, (uint)faceNormals.size() * 2, Color(0.f, 0.f, 1.f), globalMatrix);
+	if (drawVertexNormals)
+		App->debugDraw->LineBuffer(vertexNormalLines, (uint)normals.size() * 2, Color(1.f, 0.f, 0.f), globalMatrix);
+}
 
-		if (ComponentMaterial* material = owner->GetComponent<ComponentMaterial>())
-		{
-			drawWireframe || !App->renderer3D->useTexture || App->renderer3D->wireframeMode ? 0 : glBindTexture(GL_TEXTURE_2D, material->GetTextureId());
-		}
+float3 ComponentMesh::GetCenterPointInWorldCoords() const
+{
+	return owner->transform->GetGlobalMatrix().TransformPos(centerPoint);
+}
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->indexBufferId);
-
-		//-- Draw --//
-		glPushMatrix();
-		glMultMatrixf(owner->transform->transformMatrix.Transposed().ptr());
-		glColor3f(1.0f, 1.0f, 1.0f);
-		glDrawElements(GL_TRIANGLES, this->numIndices, GL_UNSIGNED_INT, NULL);
-		glPopMatrix();
-		//-- UnBind Buffers--//
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		if (this->textureBufferId)
-		{
-			glBindBuffer(GL_TEXTURE_COORD_ARRAY, 0);
-			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+void ComponentMesh::Submit(RenderQueue& queue, uint slot, uint lod)
+{
+	const bool wireframe = drawWireframe || App->renderer3D->wireframeMode;
 
-		}
-		glBindTexture(GL_TEXTURE_2D, 0);
+	MeshDrawCall call;
+	call.vertexArray = vertexArrayId;
+	call.indexType = indexType;
+	call.firstIndex = lods.empty() ? 0 : lods[lod].firstIndex;
+	call.numIndices = lods.empty() ? numIndices : lods[lod].numIndices;
+	call.transform = owner->transform->GetGlobalMatrix();
 
-		//--Disables States--//
-		glDisableClientState(GL_VERTEX_ARRAY);
+	if (ComponentMaterial* material = owner->GetComponent<ComponentMaterial>())
+	{
+		if (!wireframe && App->renderer3D->useTexture)
+			call.texture = material->GetTextureId();
+	}
 
-		App->renderer3D->wireframeMode ? glPolygonMode(GL_FRONT_AND_BACK, GL_LINE) : glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	// Drawn later, sorted with the rest of the view
+	queue.Submit(slot, call, wireframe ? RenderPass::WIREFRAME : RenderPass::OPAQUE_PASS, owner->globalAABB.CenterPoint());
+}
 
-		if (drawFaceNormals || drawVertexNormals)
-			DrawNormals();
+void ComponentMesh::DrawDebug()
+{
+	if (drawFaceNormals || drawVertexNormals)
+		DrawNormals();
 
-		if (drawAABB)
-		{
-			float3 points[8];
-			owner->globalAABB.GetCornerPoints(points);
-			DrawBoundingBox(points, float3(1.0f, 0.5f, 0.5f));
-		}
+	if (drawAABB)
+		App->debugDraw->Box(owner->globalAABB, Color(1.0f, 0.5f, 0.5f), 2.f);
 
-		if (drawOBB)
-		{
-			float3 points[8];
-			owner->globalOBB.GetCornerPoints(points);
-			DrawBoundingBox(points, float3(0.5f, 0.5f, 1.0f));
-		}
-	}
-	
-	return true;
+	if (drawOBB)
+		App->debugDraw->Box(owner->globalOBB, Color(0.5f, 0.5f, 1.0f), 2.f);
 }
 
 void ComponentMesh::OnGui()
@@ -304,7 +397,16 @@ void ComponentMesh::OnGui()
 	{
 		ImGui::Text("Num vertices %d", numVertices);
 		ImGui::Text("Num faces %d", numIndices / 3);
+		if (gpuBytes > 0)
+			ImGui::Text("GPU memory %.1f KB, %d bit indices", gpuBytes / 1024.f, indexType == IndexType::UINT16 ? 16 : 32);
+		else
+			ImGui::Text("GPU buffers shared with another copy");
+		if (cacheStats.acmr > 0.f)
+			ImGui::Text("Vertex cache: ACMR %.3f (%.3f imported), ATVR %.3f (%.3f imported)", cacheStats.acmr, sourceCacheStats.acmr, cacheStats.atvr, sourceCacheStats.atvr);
+		for (uint i = 1; i < lods.size(); ++i)
+			ImGui::Text("LOD %d: %d faces, error %.2f%%%s", i, lods[i].numIndices / 3, lods[i].error * 100.f, i == App->camera->view.GetLod(this) ? " (editor view)" : "");
 		ImGui::Checkbox("Wireframe", &drawWireframe);
+		ImGui::Checkbox("Occluder", &isOccluder);
 		ImGui::DragFloat("Normal draw scale", &normalScale);
 		ImGui::Checkbox("Draw face normals", &drawFaceNormals);
 		ImGui::Checkbox("Draw vertex normals", &drawVertexNormals);
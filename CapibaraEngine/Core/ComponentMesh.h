@@ -8,10 +8,31 @@
 #include "Geometry/OBB.h"
 #include "Geometry/AABB.h"
 #include "par_shapes.h"
+#include "MeshBVH.h"
+#include "MeshOptimizer.h"
+#include "RenderBackend.h"
+
+class RenderQueue;
+
+#define MESH_LOD_MAX 4 // Full mesh included
+#define MESH_LOD_MIN_TRIANGLES 64 // Smaller meshes are not simplified any further
+#define MESH_LOD_MIN_REDUCTION 0.85f // A level has to drop at least 15% of the triangles of the previous one
+#define MESH_LOD_MAX_ERROR 0.05f // Fraction of the mesh size a level is allowed to deviate
+#define MESH_LOD_SCREEN_ERROR 0.002f // Projected error allowed, fraction of half the view height (about a pixel)
+#define MESH_LOD_HYSTERESIS 0.2f // Switching band around each threshold, keeps levels from popping back and forth
+
+struct MeshLod
+{
+	uint firstIndex; // In the GPU index buffer, level 0 first and then lodIndices
+	uint numIndices;
+	float error; // Fraction of the mesh size
+};
 
 class ComponentMesh : public Component 
 {
 public:	
+	COMPONENT_TYPE(ComponentType::MESH)
+
 	enum class Shape
 	{
 		CUBE,
@@ -28,22 +49,28 @@ public:
 
 	void GenerateBuffers();
 	void ComputeNormals();
-	void GenerateBounds();
-	void DrawNormals() const;
+	void GenerateBounds(); // Local bounds only, safe to run on worker threads
+	void Optimize(); // Reorders triangles and vertices, CPU only, run before GenerateLods
+	void GenerateLods(); // CPU only, safe to run on worker threads before GenerateBuffers
+	void UpdateWorldBounds(); // World bounds and scene tree proxy, main thread
+	void DrawNormals();
 	float3 GetCenterPointInWorldCoords() const;
 	inline float GetSphereRadius() const { return radius; }
 	inline AABB GetAABB() { return localAABB; }
 
-	void DrawBoundingBox(float3* points, float3 color) const;
-	bool GameCamera(Frustum* cam);
-	bool Update(float dt) override;
+	uint SelectLod(float screenSize, uint currentLod) const; // Level for a view, currentLod is the one it drew last frame
+	void Submit(RenderQueue& queue, uint slot, uint lod); // Thread safe, only reads the mesh
+	void DrawDebug(); // Normals and bounding boxes, editor view only
 	void OnGui() override;
 
 	// Scene Serialization
 	void Save(JSONWriter& writer) override;
 	void Load(const JSONReader& reader) override;
 
-	uint vertexBufferId = 0, indexBufferId = 0, textureBufferId = 0;
+	uint vertexBufferId = 0, indexBufferId = 0, vertexArrayId = 0; // One interleaved vertex buffer behind the vertex array
+	IndexType indexType = IndexType::UINT32;
+	uint gpuBytes = 0; // Vertex and index buffers owned by this mesh, 0 when they are shared
+	std::string geometryKey; // Meshes with the same key share their GPU buffers, empty keeps them private
 	std::string texturePath;
 	
 	uint numVertices = 0;
@@ -59,6 +86,14 @@ public:
 	uint numIndices = 0;
 	std::vector<uint> indices;
 
+	MeshBVH bvh; // Triangle hierarchy for picking, local space
+
+	std::vector<MeshLod> lods; // lods[0] is the full mesh
+	std::vector<uint> lodIndices; // Simplified levels, indexing the same vertices
+
+	VertexCacheStats sourceCacheStats, cacheStats; // Before and after Optimize
+
+	bool isOccluder = true; // Big on screen, it hides other meshes from occlusion culling
 	bool drawWireframe = false;
 	bool drawVertexNormals = false;
 	bool drawFaceNormals = false;
@@ -73,6 +108,14 @@ private:
 	//Local coords AABB
 	AABB localAABB;
 
+	// Scene tree leaf, views find the mesh through it
+	int treeProxy = -1;
+
 	bool drawAABB = true;
 	bool drawOBB = false;
+
+	// Normals as local space line lists, built the first time they are shown and on scale changes
+	uint vertexNormalLines = 0;
+	uint faceNormalLines = 0;
+	float normalLinesScale = 0.f;
 };
\ No newline at end of file
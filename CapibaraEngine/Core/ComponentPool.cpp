@@ -0,0 +1,90 @@
+#include "ComponentPool.h"
+#include "Component.h"
+#include "ComponentTransform.h"
+#include "ComponentMesh.h"
+#include "ComponentMaterial.h"
+#include "ComponentCamera.h"
+
+#include <assert.h>
+#include <cstddef>
+
+ComponentPool::ComponentPool(size_t elementSize, uint blocksPerChunk) : blocksPerChunk(blocksPerChunk)
+{
+	// Free blocks store the next pointer in place
+	const size_t align = alignof(std::max_align_t);
+	const size_t size = elementSize > sizeof(void*) ? elementSize : sizeof(void*);
+	blockSize = (size + align - 1) & ~(align - 1);
+}
+
+ComponentPool::~ComponentPool()
+{
+	for (char* chunk : chunks)
+		::operator delete(chunk);
+
+	chunks.clear();
+}
+
+void* ComponentPool::Allocate(size_t size)
+{
+	assert(size <= blockSize);
+
+	if (freeList == nullptr)
+		AllocateChunk();
+
+	void* block = freeList;
+	freeList = *(void**)block;
+	return block;
+}
+
+void ComponentPool::Free(void* memory)
+{
+	if (memory == nullptr)
+		return;
+
+	*(void**)memory = freeList;
+	freeList = memory;
+}
+
+void ComponentPool::Add(Component* component)
+{
+	component->poolIndex = (uint)components.size();
+	components.push_back(component);
+}
+
+void ComponentPool::Remove(Component* component)
+{
+	// Swap with the last one to keep the list dense
+	const uint index = component->poolIndex;
+	Component* last = components.back();
+	components[index] = last;
+	last->poolIndex = index;
+	components.pop_back();
+}
+
+ComponentPool& ComponentPool::Get(ComponentType type)
+{
+	static ComponentPool pools[] =
+	{
+		ComponentPool(sizeof(ComponentTransform)),
+		ComponentPool(sizeof(ComponentMesh)),
+		ComponentPool(sizeof(ComponentMaterial)),
+		ComponentPool(sizeof(ComponentCamera))
+	};
+	static_assert(sizeof(pools) / sizeof(pools[0]) == (size_t)ComponentType::COUNT, "One pool per ComponentType");
+
+	return pools[(int)type];
+}
+
+void ComponentPool::AllocateChunk()
+{
+	char* chunk = (char*)::operator new(blockSize * blocksPerChunk);
+	chunks.push_back(chunk);
+
+	// Thread the new blocks onto the free list, lowest address first
+	for (uint i = blocksPerChunk; i > 0; --i)
+	{
+		void* block = chunk + blockSize * (i - 1);
+		*(void**)block = freeList;
+		freeList = block;
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Globals.h"
+#include <vector>
+
+class Component;
+
+// Every component class gets a fixed slot; GameObject lookups and pools are indexed by it
+enum class ComponentType
+{
+	TRANSFORM,
+	MESH,
+	MATERIAL,
+	CAMERA,
+	COUNT
+};
+
+// Declares the component type id and routes new/delete through the pool of that type
+#define COMPONENT_TYPE(type) \
+	static const ComponentType TYPE = type; \
+	void* operator new(size_t size) { return ComponentPool::Get(type).Allocate(size); } \
+	void operator delete(void* memory) { ComponentPool::Get(type).Free(memory); }
+
+// Fixed-size block allocator for one component type. Live components are also kept in a dense list
+// so systems can iterate every component of a type without walking the GameObject tree.
+class ComponentPool
+{
+public:
+	ComponentPool(size_t elementSize, uint blocksPerChunk = 64);
+	~ComponentPool();
+
+	void* Allocate(size_t size);
+	void Free(void* memory);
+
+	void Add(Component* component);
+	void Remove(Component* component);
+
+	inline const std::vector<Component*>& GetComponents() const { return components; }
+	inline uint GetChunkCount() const { return (uint)chunks.size(); }
+
+	static ComponentPool& Get(ComponentType type);
+
+private:
+	void AllocateChunk();
+
+private:
+	size_t blockSize;
+	uint blocksPerChunk;
+	std::vector<char*> chunks;
+	void* freeList = nullptr;
+
+	std::vector<Component*> components;
+};
@@ -7,29 +7,18 @@
 #include "glew.h"
 #include "ImGui/imgui.h"
 
-ComponentTransform::ComponentTransform(GameObject* parent) : Component(parent) {
+ComponentTransform::ComponentTransform(GameObject* parent) : Component(parent, TYPE) {
 	
 	position = float3::zero;
 	rotation = Quat::identity;
 	scale = float3::one;
 
-	transformMatrix.SetIdentity();
-	transformMatrixLocal.SetIdentity();
+	index = App->scene->transforms.Add(this);
 }
 
-
-bool ComponentTransform::Update(float dt) {
-	if (isDirty)
-	{
-		transformMatrixLocal = float4x4::FromTRS(position, rotation, scale);
-		right = transformMatrixLocal.Col3(0).Normalized();
-		up = transformMatrixLocal.Col3(1).Normalized();
-		front = transformMatrixLocal.Col3(2).Normalized();
-		RecomputeGlobalMatrix();
-		owner->PropagateTransform();
-		isDirty = false;
-	}
-	return true;
+ComponentTransform::~ComponentTransform()
+{
+	App->scene->transforms.Remove(index);
 }
 
 void ComponentTransform::OnGui()
@@ -63,7 +52,7 @@ void ComponentTransform::OnGui()
 void ComponentTransform::SetPosition(const float3& newPosition)
 {
 	position = newPosition;
-	isDirty = true;
+	UpdateLocalMatrix();
 }
 
 void ComponentTransform::SetRotation(const float3& newRotation)
@@ -71,42 +60,58 @@ void ComponentTransform::SetRotation(const float3& newRotation)
 	Quat rotationDelta = Quat::FromEulerXYZ(newRotation.x - rotationEuler.x, newRotation.y - rotationEuler.y, newRotation.z - rotationEuler.z);
 	rotation = rotation * rotationDelta;
 	rotationEuler = newRotation;
-	isDirty = true;
+	UpdateLocalMatrix();
 }
 
 void ComponentTransform::SetScale(const float3& newScale)
 {
 	scale = newScale;
-	isDirty = true;
+	UpdateLocalMatrix();
+}
+
+const float4x4& ComponentTransform::GetGlobalMatrix() const
+{
+	return App->scene->transforms.GetWorldMatrix(index);
+}
+
+const float4x4& ComponentTransform::GetLocalMatrix() const
+{
+	return App->scene->transforms.GetLocalMatrix(index);
+}
+
+void ComponentTransform::UpdateLocalMatrix()
+{
+	const float4x4 local = float4x4::FromTRS(position, rotation, scale);
+	right = local.Col3(0).Normalized();
+	up = local.Col3(1).Normalized();
+	front = local.Col3(2).Normalized();
+	App->scene->transforms.SetLocalMatrix(index, local);
 }
 
 void ComponentTransform::NewAttachment()
 {
+	// World matrices are only refreshed in the scene update, a setter called just before would be missed
+	const TransformSystem& transforms = App->scene->transforms;
+	float4x4 local = transforms.ComputeWorldMatrix(index);
 	if (owner->parent != App->scene->root)
-		transformMatrixLocal = owner->parent->transform->transformMatrix.Inverted().Mul(transformMatrix);
+		local = transforms.ComputeWorldMatrix(owner->parent->transform->GetIndex()).Inverted().Mul(local);
 
 	float3x3 rot;
-	transformMatrixLocal.Decompose(position, rot, scale);
+	local.Decompose(position, rot, scale);
+	rotation = Quat(rot);
 	rotationEuler = rot.ToEulerXYZ();
-}
 
-void ComponentTransform::OnParentMoved()
-{
-	RecomputeGlobalMatrix();
+	App->scene->transforms.SetLocalMatrix(index, local);
+	App->scene->transforms.SetParent(index, owner->parent->transform);
 }
 
-void ComponentTransform::RecomputeGlobalMatrix()
+void ComponentTransform::OnWorldMatrixChanged()
 {
-	if (owner->parent != nullptr)
-	{
-		transformMatrix = owner->parent->transform->transformMatrix.Mul(transformMatrixLocal);
-	}
-	else
-	{
-		transformMatrix = transformMatrixLocal;
-	}
-	if (owner->GetComponent<ComponentMesh>() != nullptr)
-		owner->GetComponent<ComponentMesh>()->GenerateBounds();
+	if (owner == nullptr)
+		return;
+
+	if (ComponentMesh* mesh = owner->GetComponent<ComponentMesh>())
+		mesh->UpdateWorldBounds();
 }
 
 void ComponentTransform::Save(JSONWriter& writer)
@@ -9,9 +9,11 @@ class ComponentTransform : public Component {
 
 public:
 
+	COMPONENT_TYPE(ComponentType::TRANSFORM)
+
 	ComponentTransform(GameObject* parent);
+	~ComponentTransform();
 
-	bool Update(float dt) override;
 	void OnGui() override;
 
 	void SetPosition(const float3& newPosition);
@@ -26,21 +28,27 @@ public:
 	inline const float3& Up() const { return up; }
 	inline const float3& Front() const { return front; }
 
+	// Matrices live in the scene TransformSystem, world matrices are refreshed once per frame
+	const float4x4& GetGlobalMatrix() const;
+	const float4x4& GetLocalMatrix() const;
+
 	void NewAttachment();
-	void OnParentMoved();
+	void OnWorldMatrixChanged();
 
-	void RecomputeGlobalMatrix();
+	inline uint GetIndex() const { return index; }
+	inline void SetIndex(uint newIndex) { index = newIndex; }
 	
 	// Scene Serialization
 	void Save(JSONWriter& writer) override;
 	void Load(const JSONReader& reader) override;
 
-	float4x4 transformMatrix;
-	float4x4 transformMatrixLocal;
+private:
+
+	void UpdateLocalMatrix();
 
 private:
 	
-	bool isDirty = false;
+	uint index = 0;
 
 	float3 position;
 	Quat rotation;
@@ -0,0 +1,218 @@
+#include "FrameArena.h"
+#include "p2Defs.h"
+
+#include <mutex>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstdint>
+
+static std::mutex arenasMutex;
+static std::vector<FrameArena*> arenas;
+static uint64 lastGrowthFrame = 0;
+static uint lastBlockAllocations = 0;
+
+static uint64 lastHeapAllocations = 0;
+static uint64 lastHeapFrame = 0;
+
+#ifdef FRAME_ARENA_COUNT_HEAP
+static std::atomic<bool> countHeap(false);
+static std::atomic<uint64> heapAllocations(0);
+static uint64 frameStartHeapAllocations = 0;
+#endif
+
+static thread_local FrameArena* threadArena = nullptr;
+
+FrameArena& FrameArena::Get()
+{
+	if (threadArena == nullptr)
+	{
+		FrameArena* arena = new FrameArena();
+
+		std::lock_guard<std::mutex> lock(arenasMutex);
+		arenas.push_back(arena);
+		threadArena = arena;
+	}
+	return *threadArena;
+}
+
+void FrameArena::ResetAll(uint64 frame)
+{
+	std::lock_guard<std::mutex> lock(arenasMutex);
+
+	// Taken before the reset, merging a grown chain is part of the growth of that frame
+	lastBlockAllocations = 0;
+	for (FrameArena* arena : arenas)
+	{
+		lastBlockAllocations += arena->blockAllocations;
+		arena->Reset();
+	}
+
+	if (lastBlockAllocations > 0)
+		lastGrowthFrame = frame;
+
+#ifdef FRAME_ARENA_COUNT_HEAP
+	// Read after the reset, merging a grown chain belongs to the frame that grew it
+	if (countHeap.load(std::memory_order_relaxed))
+	{
+		const uint64 total = heapAllocations.load(std::memory_order_relaxed);
+		lastHeapAllocations = total - frameStartHeapAllocations;
+		frameStartHeapAllocations = total;
+		if (lastHeapAllocations > 0)
+			lastHeapFrame = frame;
+	}
+#endif
+}
+
+#ifdef FRAME_ARENA_COUNT_HEAP
+void FrameArena::SetCountHeapAllocations(bool count)
+{
+	std::lock_guard<std::mutex> lock(arenasMutex);
+	frameStartHeapAllocations = heapAllocations.load(std::memory_order_relaxed);
+	lastHeapAllocations = 0;
+	countHeap.store(count, std::memory_order_relaxed);
+}
+#endif
+
+void FrameArena::ReleaseAll()
+{
+	std::lock_guard<std::mutex> lock(arenasMutex);
+	for (FrameArena* arena : arenas)
+		RELEASE(arena);
+	arenas.clear();
+
+	// Only called once the workers are gone, the main thread creates a new arena if it needs one
+	threadArena = nullptr;
+}
+
+void FrameArena::GetStats(FrameArenaStats& stats)
+{
+	stats = FrameArenaStats();
+
+	std::lock_guard<std::mutex> lock(arenasMutex);
+	stats.threads = (uint)arenas.size();
+	for (const FrameArena* arena : arenas)
+	{
+		stats.usedBytes += arena->lastUsed;
+		for (const Block& block : arena->blocks)
+			stats.capacityBytes += block.size;
+	}
+	stats.blockAllocations = lastBlockAllocations;
+	stats.lastGrowthFrame = lastGrowthFrame;
+	stats.heapAllocations = lastHeapAllocations;
+	stats.lastHeapFrame = lastHeapFrame;
+}
+
+bool FrameArena::IsSteady(uint64 frame)
+{
+	std::lock_guard<std::mutex> lock(arenasMutex);
+	return frame > FRAME_ARENA_WARMUP_FRAMES && lastGrowthFrame <= FRAME_ARENA_WARMUP_FRAMES && lastHeapFrame <= FRAME_ARENA_WARMUP_FRAMES;
+}
+
+FrameArena::FrameArena()
+{
+	AddBlock(FRAME_ARENA_BLOCK_SIZE);
+	blockAllocations = 0; // The first block is not growth
+}
+
+FrameArena::~FrameArena()
+{
+	for (Block& block : blocks)
+		RELEASE_ARRAY(block.data);
+	blocks.clear();
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+	for (;;)
+	{
+		Block& block = blocks[current];
+		const uintptr_t base = (uintptr_t)block.data;
+		const size_t aligned = (size_t)(((base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+		if (aligned + size <= block.size)
+		{
+			used += aligned + size - offset;
+			offset = aligned + size;
+			return block.data + aligned;
+		}
+
+		offset = 0;
+		AddBlock(size + alignment);
+	}
+}
+
+void FrameArena::Reset()
+{
+	lastUsed = used;
+	used = 0;
+	current = 0;
+	offset = 0;
+	blockAllocations = 0;
+
+	if (blocks.size() == 1)
+		return;
+
+	// The busiest frame so far fits in one block from now on
+	size_t total = 0;
+	for (Block& block : blocks)
+	{
+		total += block.size;
+		RELEASE_ARRAY(block.data);
+	}
+	blocks.clear();
+	AddBlock(total);
+	blockAllocations = 0;
+}
+
+void FrameArena::AddBlock(size_t minSize)
+{
+	// Doubling keeps the chain short for a frame much bigger than the last one
+	const size_t last = blocks.empty() ? 0 : blocks.back().size;
+	Block block;
+	block.size = minSize > last * 2 ? minSize : last * 2;
+	block.data = new char[block.size];
+	blocks.push_back(block);
+	current = (uint)blocks.size() - 1;
+	++blockAllocations;
+}
+
+#ifdef FRAME_ARENA_COUNT_HEAP
+// Replaced for the whole program so a steady frame can be checked for heap allocations, the other
+// forms of new and delete end up here. Only in the builds that ask for it, nothing else should pay
+// for it or lose the allocator of the runtime.
+void* operator new(size_t size)
+{
+	if (countHeap.load(std::memory_order_relaxed))
+		heapAllocations.fetch_add(1, std::memory_order_relaxed);
+
+	void* memory = malloc(size > 0 ? size : 1);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	free(memory);
+}
+#endif
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Globals.h"
+
+#include <vector>
+#include <deque>
+#include <queue>
+#include <stack>
+
+#define FRAME_ARENA_BLOCK_SIZE (256 * 1024) // First block of every thread
+#define FRAME_ARENA_WARMUP_FRAMES 10 // Frames allowed to grow the arenas before a steady state is expected
+
+struct FrameArenaStats
+{
+	uint threads = 0;
+	size_t usedBytes = 0; // Last frame, all threads
+	size_t capacityBytes = 0;
+	uint blockAllocations = 0; // Heap blocks taken during the last frame
+	uint64 lastGrowthFrame = 0; // 0 if the arenas never grew
+
+	// Only while heap allocations are counted, see FRAME_ARENA_COUNT_HEAP
+	uint64 heapAllocations = 0; // Global operator new calls during the last frame, any thread
+	uint64 lastHeapFrame = 0; // Last frame that called it, 0 if none did
+};
+
+// Linear allocator for data that only lives during one frame. Every thread bumps its own arena, so
+// no allocation takes a lock, and all of them are reset at once when the next frame starts. A block
+// that runs out chains a new one; on reset the chain is merged into a single block big enough for the
+// whole frame, so once a scene is warmed up a frame takes nothing from the heap.
+// Memory is never freed on its own: nothing allocated here may be kept across PrepareUpdate.
+class FrameArena
+{
+public:
+	static FrameArena& Get(); // Of the calling thread
+
+	// Main thread at the start of the frame, no job may be running
+	static void ResetAll(uint64 frame);
+	static void ReleaseAll();
+
+	static void GetStats(FrameArenaStats& stats);
+	static bool IsSteady(uint64 frame); // No growth and, if counted, no heap allocation since the warm-up
+
+#ifdef FRAME_ARENA_COUNT_HEAP
+	// Builds defining it replace the global operator new, its calls are counted while enabled and
+	// cost a relaxed load otherwise. Allocations through malloc, like the ImGui ones, are not seen.
+	static void SetCountHeapAllocations(bool count);
+#endif
+
+	void* Allocate(size_t size, size_t alignment);
+
+	template<typename T>
+	inline T* Allocate(size_t count) { return static_cast<T*>(Allocate(count * sizeof(T), alignof(T))); }
+
+private:
+	FrameArena();
+	~FrameArena();
+
+	void Reset();
+	void AddBlock(size_t minSize);
+
+private:
+	struct Block
+	{
+		char* data = nullptr;
+		size_t size = 0;
+	};
+
+	std::vector<Block> blocks;
+	uint current = 0;
+	size_t offset = 0;
+
+	size_t used = 0; // This frame
+	size_t lastUsed = 0;
+	uint blockAllocations = 0;
+};
+
+// STL allocator on the arena of the thread that creates it. Containers using it are meant to be
+// locals of the frame: filled on one thread, never kept across frames. Deallocation does nothing.
+template<typename T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+
+	FrameAllocator() : arena(&FrameArena::Get()) {}
+	template<typename U>
+	FrameAllocator(const FrameAllocator<U>& other) : arena(other.arena) {}
+
+	inline T* allocate(size_t count) { return arena->Allocate<T>(count); }
+	inline void deallocate(T*, size_t) {}
+
+	template<typename U>
+	inline bool operator==(const FrameAllocator<U>& other) const { return arena == other.arena; }
+	template<typename U>
+	inline bool operator!=(const FrameAllocator<U>& other) const { return arena != other.arena; }
+
+private:
+	template<typename U> friend class FrameAllocator;
+	FrameArena* arena;
+};
+
+template<typename T> using FrameVector = std::vector<T, FrameAllocator<T>>;
+template<typename T> using FrameQueue = std::queue<T, std::deque<T, FrameAllocator<T>>>;
+template<typename T> using FrameStack = std::stack<T, std::deque<T, FrameAllocator<T>>>;
@@ -0,0 +1,124 @@
+#include "FrameTiming.h"
+#include "PerfTimer.h"
+
+#include "SDL/include/SDL_timer.h"
+#include <mmsystem.h>
+
+#include <algorithm>
+
+#pragma comment( lib, "winmm.lib" )
+
+#define FRAME_LIMITER_MIN_SPIN_MS 0.5
+#define FRAME_LIMITER_MAX_SPIN_MS 4.0
+
+bool FrameStats::AddFrame(uint64 frame, double ms)
+{
+	history[next] = (float)ms;
+	next = (next + 1) % FRAME_STATS_HISTORY;
+	if (count < FRAME_STATS_HISTORY)
+		++count;
+
+	if (ms <= hitchThresholdMs)
+		return false;
+
+	FramePercentiles percentiles;
+	GetPercentiles(percentiles);
+
+	// Oldest snapshot is reused, its vector keeps the capacity
+	FrameHitch& hitch = hitches[totalHitches % FRAME_STATS_MAX_HITCHES];
+	hitch.frame = frame;
+	hitch.ms = ms;
+	hitch.medianMs = percentiles.p50;
+
+	// Zones only if the profiler kept this very frame, paused it still shows an older one
+	const Profiler& profiler = Profiler::Get();
+	if (Profiler::IsRecording() && !profiler.paused && profiler.GetLastFrameNumber() == frame)
+	{
+		hitch.zones = profiler.GetLastFrame();
+		hitch.start = profiler.GetLastFrameStart();
+		hitch.end = profiler.GetLastFrameEnd();
+	}
+	else
+	{
+		hitch.zones.clear();
+		hitch.start = hitch.end = 0;
+	}
+	++totalHitches;
+
+	LOG("Hitch: frame %llu took %.2f ms, median %.2f ms", frame, ms, percentiles.p50);
+	return true;
+}
+
+void FrameStats::GetPercentiles(FramePercentiles& percentiles) const
+{
+	percentiles = FramePercentiles();
+	if (count == 0)
+		return;
+
+	sorted.assign(history, history + count);
+	std::sort(sorted.begin(), sorted.end());
+
+	// Nearest rank, so every value is a frame that really happened
+	auto rank = [this](double p) { return (double)sorted[(uint)(p * (sorted.size() - 1) + 0.5)]; };
+	percentiles.p50 = rank(0.5);
+	percentiles.p95 = rank(0.95);
+	percentiles.p99 = rank(0.99);
+	percentiles.max = sorted.back();
+	percentiles.count = count;
+}
+
+void FrameStats::GetHitches(FrameVector<const FrameHitch*>& hitches) const
+{
+	hitches.clear();
+	const uint kept = totalHitches < FRAME_STATS_MAX_HITCHES ? totalHitches : FRAME_STATS_MAX_HITCHES;
+	for (uint i = 1; i <= kept; ++i)
+		hitches.push_back(&this->hitches[(totalHitches - i) % FRAME_STATS_MAX_HITCHES]);
+}
+
+void FrameStats::ClearHitches()
+{
+	for (FrameHitch& hitch : hitches)
+		hitch.zones.clear();
+	totalHitches = 0;
+}
+
+FrameLimiter::FrameLimiter()
+{
+	// Sleeps are rounded up to the scheduler period, 15.6 ms by default on Windows
+	timeBeginPeriod(1);
+}
+
+FrameLimiter::~FrameLimiter()
+{
+	timeEndPeriod(1);
+}
+
+void FrameLimiter::Wait(const PerfTimer& frameTimer, int fps)
+{
+	lastWaitMs = 0.0;
+	if (fps <= 0)
+		return;
+
+	const double targetMs = 1000.0 / fps;
+	const double startMs = frameTimer.ReadMs();
+
+	while (targetMs - frameTimer.ReadMs() > spinMarginMs)
+	{
+		PerfTimer sleepTimer;
+		SDL_Delay(1);
+
+		// Keep enough margin for the worst sleep, shrinking slowly when sleeps get precise again
+		const double overshootMs = sleepTimer.ReadMs() - 1.0;
+		spinMarginMs = overshootMs + 0.25 > spinMarginMs * 0.99 ? overshootMs + 0.25 : spinMarginMs * 0.99;
+		if (spinMarginMs < FRAME_LIMITER_MIN_SPIN_MS)
+			spinMarginMs = FRAME_LIMITER_MIN_SPIN_MS;
+		if (spinMarginMs > FRAME_LIMITER_MAX_SPIN_MS)
+			spinMarginMs = FRAME_LIMITER_MAX_SPIN_MS;
+	}
+
+	while (frameTimer.ReadMs() < targetMs)
+	{
+	}
+
+	lastWaitMs = frameTimer.ReadMs() - startMs;
+}
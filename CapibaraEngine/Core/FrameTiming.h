@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Globals.h"
+#include "Profiler.h"
+#include "FrameArena.h"
+
+#include <vector>
+
+class PerfTimer;
+
+#define FRAME_STATS_HISTORY 1024 // Frames kept for the graph and the percentiles
+#define FRAME_STATS_MAX_HITCHES 8 // Newest hitches kept, with the profiler zones of their frame
+
+struct FramePercentiles
+{
+	double p50 = 0.0;
+	double p95 = 0.0;
+	double p99 = 0.0;
+	double max = 0.0;
+	uint count = 0;
+};
+
+struct FrameHitch
+{
+	uint64 frame = 0;
+	double ms = 0.0;
+	double medianMs = 0.0; // Of the history when it happened
+	std::vector<ProfileEvent> zones; // Empty if the profiler was not recording or was paused
+	uint64 start = 0; // Profiler ticks of the frame
+	uint64 end = 0;
+};
+
+// Frame times in a ring, from which tail percentiles are taken on demand. A frame slower than the
+// threshold is a hitch: the profiler zones of that frame are copied so they can be inspected later.
+class FrameStats
+{
+public:
+	// Frame times in milliseconds, call after the profiler ended the frame. True if it was a hitch.
+	bool AddFrame(uint64 frame, double ms);
+
+	void GetPercentiles(FramePercentiles& percentiles) const;
+
+	// Oldest first starting at the offset, as ImGui::PlotLines wants a ring
+	inline const float* GetHistory() const { return history; }
+	inline uint GetHistoryCount() const { return count; }
+	inline uint GetHistoryOffset() const { return count < FRAME_STATS_HISTORY ? 0 : next; }
+	inline float GetLastMs() const { return count > 0 ? history[(next + FRAME_STATS_HISTORY - 1) % FRAME_STATS_HISTORY] : 0.f; }
+
+	void GetHitches(FrameVector<const FrameHitch*>& hitches) const; // Newest first
+	inline uint GetHitchCount() const { return totalHitches; }
+	void ClearHitches();
+
+public:
+	float hitchThresholdMs = 50.f;
+
+private:
+	float history[FRAME_STATS_HISTORY];
+	uint count = 0;
+	uint next = 0;
+
+	FrameHitch hitches[FRAME_STATS_MAX_HITCHES];
+	uint totalHitches = 0;
+
+	mutable std::vector<float> sorted; // Scratch for the percentiles
+};
+
+// Holds the frame until it lasts 1000 / fps milliseconds. It sleeps while there is time left and spins
+// the last stretch, since a sleep can overshoot by more than a millisecond. The spin margin follows
+// the worst overshoot seen.
+class FrameLimiter
+{
+public:
+	FrameLimiter();
+	~FrameLimiter();
+
+	void Wait(const PerfTimer& frameTimer, int fps); // No limit with fps <= 0
+
+	inline double GetLastWaitMs() const { return lastWaitMs; }
+	inline double GetSpinMarginMs() const { return spinMarginMs; }
+
+private:
+	double spinMarginMs = 2.0;
+	double lastWaitMs = 0.0;
+};
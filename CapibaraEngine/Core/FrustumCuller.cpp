@@ -0,0 +1,183 @@
+#include "FrustumCuller.h"
+#include "PerfTimer.h"
+#include "Geometry/Plane.h"
+#include "Algorithm/Random/LCG.h"
+
+#ifdef FRUSTUM_CULLER_SSE
+#include <xmmintrin.h>
+#include <intrin.h>
+#endif
+
+void FrustumCuller::Clear()
+{
+	centerX.clear(); centerY.clear(); centerZ.clear();
+	extentX.clear(); extentY.clear(); extentZ.clear();
+	count = 0;
+}
+
+void FrustumCuller::Reserve(uint numBoxes)
+{
+	const uint padded = (numBoxes + 3) & ~3u;
+	centerX.reserve(padded); centerY.reserve(padded); centerZ.reserve(padded);
+	extentX.reserve(padded); extentY.reserve(padded); extentZ.reserve(padded);
+}
+
+uint FrustumCuller::Add(const AABB& box)
+{
+	// Grow a whole SIMD lane group at a time
+	if ((count & 3) == 0)
+	{
+		const uint padded = count + 4;
+		centerX.resize(padded, 0.f); centerY.resize(padded, 0.f); centerZ.resize(padded, 0.f);
+		extentX.resize(padded, 0.f); extentY.resize(padded, 0.f); extentZ.resize(padded, 0.f);
+	}
+
+	const float3 center = box.CenterPoint();
+	const float3 extents = box.HalfSize();
+	centerX[count] = center.x; centerY[count] = center.y; centerZ[count] = center.z;
+	extentX[count] = extents.x; extentY[count] = extents.y; extentZ[count] = extents.z;
+
+	return count++;
+}
+
+void FrustumCuller::Cull(const Frustum& frustum, std::vector<uint>& visible) const
+{
+#ifdef FRUSTUM_CULLER_SSE
+	CullSSE(frustum, visible);
+#else
+	CullScalar(frustum, visible);
+#endif
+}
+
+void FrustumCuller::CullScalar(const Frustum& frustum, std::vector<uint>& visible) const
+{
+	Plane planes[6];
+	float3 absNormals[6];
+	frustum.GetPlanes(planes);
+	for (int p = 0; p < 6; ++p)
+		absNormals[p] = planes[p].normal.Abs();
+
+	for (uint i = 0; i < count; ++i)
+	{
+		// Planes point outwards, a box completely in front of one of them is outside
+		bool outside = false;
+		for (int p = 0; p < 6 && !outside; ++p)
+		{
+			const float3& n = planes[p].normal;
+			const float distance = n.x * centerX[i] + n.y * centerY[i] + n.z * centerZ[i] - planes[p].d;
+			const float radius = absNormals[p].x * extentX[i] + absNormals[p].y * extentY[i] + absNormals[p].z * extentZ[i];
+			outside = distance - radius > 0.f;
+		}
+
+		if (!outside)
+			visible.push_back(i);
+	}
+}
+
+#ifdef FRUSTUM_CULLER_SSE
+void FrustumCuller::CullSSE(const Frustum& frustum, std::vector<uint>& visible) const
+{
+	Plane planes[6];
+	frustum.GetPlanes(planes);
+
+	// Plane terms splatted once, absolute normals give the projected extents
+	__m128 nx[6], ny[6], nz[6], ax[6], ay[6], az[6], d[6];
+	for (int p = 0; p < 6; ++p)
+	{
+		const float3& n = planes[p].normal;
+		const float3 a = n.Abs();
+		nx[p] = _mm_set1_ps(n.x); ny[p] = _mm_set1_ps(n.y); nz[p] = _mm_set1_ps(n.z);
+		ax[p] = _mm_set1_ps(a.x); ay[p] = _mm_set1_ps(a.y); az[p] = _mm_set1_ps(a.z);
+		d[p] = _mm_set1_ps(planes[p].d);
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+
+	for (uint i = 0; i < count; i += 4)
+	{
+		const __m128 cx = _mm_loadu_ps(&centerX[i]);
+		const __m128 cy = _mm_loadu_ps(&centerY[i]);
+		const __m128 cz = _mm_loadu_ps(&centerZ[i]);
+		const __m128 ex = _mm_loadu_ps(&extentX[i]);
+		const __m128 ey = _mm_loadu_ps(&extentY[i]);
+		const __m128 ez = _mm_loadu_ps(&extentZ[i]);
+
+		__m128 outside = zero;
+		for (int p = 0; p < 6; ++p)
+		{
+			const __m128 distance = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)), _mm_mul_ps(nz[p], cz)), d[p]);
+			const __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)), _mm_mul_ps(az[p], ez));
+			outside = _mm_or_ps(outside, _mm_cmpgt_ps(_mm_sub_ps(distance, radius), zero));
+		}
+
+		// One bit per visible lane, padding lanes past count are dropped
+		unsigned long mask = ~_mm_movemask_ps(outside) & 0xF;
+		const uint lanes = count - i;
+		if (lanes < 4)
+			mask &= (1u << lanes) - 1;
+
+		unsigned long lane;
+		while (_BitScanForward(&lane, mask))
+		{
+			mask &= mask - 1;
+			visible.push_back(i + lane);
+		}
+	}
+}
+#endif
+
+FrustumCullerBenchmark FrustumCuller::RunBenchmark(uint numBoxes, uint iterations)
+{
+	FrustumCullerBenchmark result;
+	result.numBoxes = numBoxes;
+
+	// Boxes scattered around a camera looking down +Z, about a sixth ends up visible
+	LCG random(1234);
+	FrustumCuller culler;
+	culler.Reserve(numBoxes);
+	for (uint i = 0; i < numBoxes; ++i)
+	{
+		const float3 center(random.Float(-500.f, 500.f), random.Float(-50.f, 50.f), random.Float(-500.f, 500.f));
+		const float3 extents(random.Float(0.5f, 5.f), random.Float(0.5f, 5.f), random.Float(0.5f, 5.f));
+		culler.Add(AABB(center - extents, center + extents));
+	}
+
+	Frustum frustum;
+	frustum.type = FrustumType::PerspectiveFrustum;
+	frustum.pos = float3::zero;
+	frustum.front = float3::unitZ;
+	frustum.up = float3::unitY;
+	frustum.nearPlaneDistance = 0.1f;
+	frustum.farPlaneDistance = 400.f;
+	frustum.verticalFov = 60.f * DEGTORAD;
+	frustum.horizontalFov = 90.f * DEGTORAD;
+
+	std::vector<uint> scalarVisible, simdVisible;
+	scalarVisible.reserve(numBoxes);
+	simdVisible.reserve(numBoxes);
+
+	PerfTimer timer;
+	timer.Start();
+	for (uint i = 0; i < iterations; ++i)
+	{
+		scalarVisible.clear();
+		culler.CullScalar(frustum, scalarVisible);
+	}
+	result.scalarMs = timer.ReadMs() / iterations;
+
+	timer.Start();
+	for (uint i = 0; i < iterations; ++i)
+	{
+		simdVisible.clear();
+		culler.Cull(frustum, simdVisible);
+	}
+	result.simdMs = timer.ReadMs() / iterations;
+
+	result.visible = (uint)simdVisible.size();
+	result.resultsMatch = scalarVisible == simdVisible;
+
+	LOG("Frustum culling %d boxes: scalar %.3f ms, simd %.3f ms, %d visible%s", numBoxes, result.scalarMs, result.simdMs, result.visible,
+		result.resultsMatch ? "" : " (MISMATCH)");
+
+	return result;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Globals.h"
+#include "Geometry/AABB.h"
+#include "Geometry/Frustum.h"
+#include <vector>
+
+// MathGeoLib is built without MATH_SSE, so the SIMD path uses the SSE intrinsics directly
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define FRUSTUM_CULLER_SSE
+#endif
+
+struct FrustumCullerBenchmark
+{
+	uint numBoxes = 0;
+	uint visible = 0;
+	double scalarMs = 0.0;
+	double simdMs = 0.0;
+	bool resultsMatch = false;
+};
+
+// World AABBs packed as structure of arrays (center and extents) and culled against the six
+// frustum planes four boxes at a time. Output is the compact list of box indices that are visible.
+class FrustumCuller
+{
+public:
+	void Clear();
+	void Reserve(uint count);
+	uint Add(const AABB& box); // Returns the box index
+
+	inline uint Size() const { return count; }
+
+	// Appends visible box indices, uses SSE when available
+	void Cull(const Frustum& frustum, std::vector<uint>& visible) const;
+	void CullScalar(const Frustum& frustum, std::vector<uint>& visible) const;
+#ifdef FRUSTUM_CULLER_SSE
+	void CullSSE(const Frustum& frustum, std::vector<uint>& visible) const;
+#endif
+
+	// Times both paths on random boxes and checks they agree
+	static FrustumCullerBenchmark RunBenchmark(uint numBoxes, uint iterations);
+
+private:
+	// Padded to a multiple of 4, padding lanes are masked out
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+	uint count = 0;
+};
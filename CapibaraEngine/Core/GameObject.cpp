@@ -76,12 +76,31 @@ void GameObject::DeleteComponent(Component* component) {
 	{
 		components.erase(componentIt);
 		components.shrink_to_fit();
+
+		// The next component of the same type, if any, takes over the slot
+		const int type = (int)component->GetType();
+		if (typedComponents[type] == component)
+		{
+			typedComponents[type] = nullptr;
+			for (Component* remaining : components)
+			{
+				if ((int)remaining->GetType() == type)
+				{
+					typedComponents[type] = remaining;
+					break;
+				}
+			}
+		}
 	}
 }
 
 void GameObject::AddComponent(Component* component)
 {
 	components.push_back(component);
+
+	// First component of each type answers GetComponent
+	if (typedComponents[(int)component->GetType()] == nullptr)
+		typedComponents[(int)component->GetType()] = component;
 }
 
 void GameObject::AttachChild(GameObject* child)
@@ -89,7 +108,6 @@ void GameObject::AttachChild(GameObject* child)
 	child->parent = this;
 	children.push_back(child);
 	child->transform->NewAttachment();
-	child->PropagateTransform();
 	App->scene->gameObjectList.push_back(child);
 }
 
@@ -102,14 +120,6 @@ void GameObject::RemoveChild(GameObject* child)
 	}
 }
 
-void GameObject::PropagateTransform()
-{
-	for (GameObject* go : children)
-	{
-		go->transform->OnParentMoved();
-	}
-}
-
 void GameObject::Save(JSONWriter& writer)
 {
 	// Object material
@@ -175,7 +185,7 @@ void GameObject::Load(const JSONReader& reader)
 			if (rapidAuto[i] != nullptr)
 			{
 				newComponent->Load(reader);
-				components.push_back(newComponent);
+				AddComponent(newComponent);
 			}
 		}
 	}
@@ -4,6 +4,7 @@
 #include <string>
 #include "Geometry/OBB.h"
 #include "Geometry/AABB.h"
+#include "ComponentPool.h"
 
 #include "rapidjson-1.1.0/include/rapidjson/prettywriter.h"
 #include "rapidjson-1.1.0/include/rapidjson/document.h"
@@ -34,21 +35,13 @@ public:
 
 	template<class T> T* GetComponent()
 	{
-		T* component = nullptr; 
-		for (Component* c : components)
-		{
-			component = dynamic_cast<T*>(c);
-			if (component)
-				break;
-		}
-		return component;
+		return static_cast<T*>(typedComponents[(int)T::TYPE]);
 	}
 
 	void DeleteComponent(Component* component);
 	void AddComponent(Component* component);
 	void AttachChild(GameObject* child);
 	void RemoveChild(GameObject* child);
-	void PropagateTransform();
 
 	// Scene Serialization
 	void Save(JSONWriter& writer);
@@ -59,6 +52,7 @@ public:
 	ComponentTransform* transform = nullptr;
 	std::vector<GameObject*> children;
 	std::vector<Component*> components;
+	Component* typedComponents[(int)ComponentType::COUNT] = {};
 	
 	bool active = true;
 	bool isSelected = false;
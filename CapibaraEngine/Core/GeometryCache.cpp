@@ -0,0 +1,35 @@
+#include "GeometryCache.h"
+#include "RenderBackend.h"
+
+bool GeometryCache::Acquire(const std::string& key, SharedGeometry& geometry)
+{
+	auto it = entries.find(key);
+	if (it == entries.end())
+		return false;
+
+	++it->second.refCount;
+	geometry = it->second;
+	return true;
+}
+
+void GeometryCache::Add(const std::string& key, const SharedGeometry& geometry)
+{
+	SharedGeometry& entry = entries[key];
+	entry = geometry;
+	entry.refCount = 1;
+}
+
+void GeometryCache::Release(const std::string& key, RenderBackend* backend)
+{
+	auto it = entries.find(key);
+	if (it == entries.end())
+		return;
+
+	if (--it->second.refCount == 0)
+	{
+		backend->DeleteVertexArray(it->second.vertexArray);
+		backend->DeleteBuffer(it->second.vertexBuffer);
+		backend->DeleteBuffer(it->second.indexBuffer);
+		entries.erase(it);
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Globals.h"
+#include "RenderBackend.h"
+#include <string>
+#include <unordered_map>
+
+struct SharedGeometry
+{
+	uint vertexBuffer = 0;
+	uint indexBuffer = 0;
+	uint vertexArray = 0;
+	IndexType indexType = IndexType::UINT32;
+	uint refCount = 0;
+};
+
+// GPU buffers of meshes that are placed more than once (primitives, a model imported again)
+// are uploaded a single time and reference counted. Sharing the same ids is also what lets
+// the render queue batch the copies into one instanced draw.
+class GeometryCache
+{
+public:
+	// Fills the buffers and takes a reference when the key is already uploaded
+	bool Acquire(const std::string& key, SharedGeometry& geometry);
+	void Add(const std::string& key, const SharedGeometry& geometry);
+	// Deletes the buffers when the last reference goes away
+	void Release(const std::string& key, RenderBackend* backend);
+
+	inline uint Size() const { return (uint)entries.size(); }
+
+private:
+	std::unordered_map<std::string, SharedGeometry> entries;
+};
@@ -0,0 +1,338 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "p2Defs.h"
+
+#define JOB_SYSTEM_QUEUE_MASK (JOB_SYSTEM_QUEUE_SIZE - 1)
+
+// Deque owned by the calling thread, the main thread and any thread outside the system use 0
+static thread_local uint threadIndex = 0;
+
+JobQueue::JobQueue() : top(0), bottom(0)
+{
+	for (uint i = 0; i < JOB_SYSTEM_QUEUE_SIZE; ++i)
+		jobs[i].store(nullptr, std::memory_order_relaxed);
+}
+
+bool JobQueue::Push(Job* job)
+{
+	const long long b = bottom.load(std::memory_order_relaxed);
+	const long long t = top.load(std::memory_order_acquire);
+	if (b - t >= JOB_SYSTEM_QUEUE_SIZE)
+		return false;
+
+	jobs[b & JOB_SYSTEM_QUEUE_MASK].store(job, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	bottom.store(b + 1, std::memory_order_relaxed);
+	return true;
+}
+
+Job* JobQueue::Pop()
+{
+	const long long b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	long long t = top.load(std::memory_order_relaxed);
+
+	if (t > b)
+	{
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = jobs[b & JOB_SYSTEM_QUEUE_MASK].load(std::memory_order_relaxed);
+	if (t == b)
+	{
+		// Last job left, the thieves may be after it too
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			job = nullptr;
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* JobQueue::Steal()
+{
+	long long t = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	const long long b = bottom.load(std::memory_order_acquire);
+	if (t >= b)
+		return nullptr;
+
+	Job* job = jobs[t & JOB_SYSTEM_QUEUE_MASK].load(std::memory_order_relaxed);
+	if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return nullptr;
+	return job;
+}
+
+JobSystem::JobSystem() : queued(0), sleeping(0)
+{
+	threadData.push_back(new ThreadData());
+}
+
+JobSystem::~JobSystem()
+{
+	Stop();
+	for (ThreadData* data : threadData)
+		RELEASE(data);
+	threadData.clear();
+}
+
+void JobSystem::Start(uint numWorkers)
+{
+	Stop();
+
+	for (uint i = 0; i < numWorkers; ++i)
+		threadData.push_back(new ThreadData());
+
+	stopping = false;
+	threadIndex = 0;
+	for (uint i = 0; i < numWorkers; ++i)
+		workers.push_back(std::thread(&JobSystem::WorkerLoop, this, i + 1));
+}
+
+void JobSystem::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+	workers.clear();
+
+	for (uint i = 1; i < threadData.size(); ++i)
+		RELEASE(threadData[i]);
+	threadData.resize(1);
+}
+
+void JobSystem::Run(const std::function<void()>& task, JobCounter* counter)
+{
+	if (singleThreaded)
+	{
+		task();
+		return;
+	}
+
+	if (counter)
+		counter->pending.fetch_add(1);
+
+	Job* job = AllocateJob(task, counter);
+	if (job == nullptr)
+	{
+		task();
+		Finish(counter);
+		return;
+	}
+	Push(job);
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, const std::function<void()>& task, JobCounter* counter)
+{
+	if (singleThreaded)
+	{
+		task();
+		return;
+	}
+
+	if (counter)
+		counter->pending.fetch_add(1);
+	Job* job = AllocateJob(task, counter);
+	if (job == nullptr)
+	{
+		Wait(dependency);
+		task();
+		Finish(counter);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(dependency.mutex);
+		if (dependency.pending.load() != 0)
+		{
+			dependency.continuations.push_back(job);
+			return;
+		}
+	}
+	Push(job);
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	while (!counter.IsDone())
+	{
+		if (!RunOne())
+			std::this_thread::yield();
+	}
+
+	// The last job may still hold the lock, the counter can only go away once it is released
+	std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+void JobSystem::ParallelFor(uint count, const std::function<void(uint)>& task)
+{
+	if (count == 0)
+		return;
+
+	const uint maxRanges = GetNumThreads() * JOB_SYSTEM_JOBS_PER_THREAD;
+	const uint numRanges = count < maxRanges ? count : maxRanges;
+	if (singleThreaded || workers.empty() || numRanges == 1)
+	{
+		for (uint i = 0; i < count; ++i)
+			task(i);
+		return;
+	}
+
+	// Nothing is shared between calls: every job owns its range and the counter is local, so a worker
+	// still finishing a previous call can neither take an index of this one nor end it early
+	JobCounter counter;
+	for (uint range = 0; range < numRanges; ++range)
+	{
+		const uint first = range * count / numRanges;
+		const uint last = (range + 1) * count / numRanges;
+		Run([&task, first, last]()
+		{
+			for (uint i = first; i < last; ++i)
+				task(i);
+		}, &counter);
+	}
+	Wait(counter);
+}
+
+void JobSystem::SetSingleThreaded(bool singleThreaded)
+{
+	this->singleThreaded = singleThreaded;
+}
+
+void JobSystem::GetStats(std::vector<JobThreadStats>& stats)
+{
+	stats.resize(threadData.size());
+	for (uint i = 0; i < threadData.size(); ++i)
+	{
+		stats[i].executed = threadData[i]->executed.exchange(0);
+		stats[i].stolen = threadData[i]->stolen.exchange(0);
+	}
+}
+
+void JobSystem::WorkerLoop(uint index)
+{
+	threadIndex = index;
+	Profiler::Get().SetThreadName(("Worker " + std::to_string(index)).c_str());
+
+	uint spins = 0;
+	while (true)
+	{
+		if (RunOne())
+		{
+			spins = 0;
+			continue;
+		}
+
+		if (++spins < JOB_SYSTEM_SPIN_COUNT)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		spins = 0;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleeping.fetch_add(1);
+		wakeUp.wait(lock, [this]() { return stopping || queued.load() > 0; });
+		sleeping.fetch_sub(1);
+		if (stopping)
+			return;
+	}
+}
+
+Job* JobSystem::AllocateJob(const std::function<void()>& task, JobCounter* counter)
+{
+	ThreadData& data = *threadData[GetThreadIndex()];
+	Job* job = &data.jobs[data.nextJob];
+
+	// A whole turn of the ring is still queued or running, its task may be executing on another thread
+	if (job->inFlight.load(std::memory_order_acquire))
+		return nullptr;
+	data.nextJob = (data.nextJob + 1) % JOB_SYSTEM_MAX_JOBS;
+
+	job->inFlight.store(true, std::memory_order_relaxed);
+	job->task = task;
+	job->counter = counter;
+	return job;
+}
+
+void JobSystem::Push(Job* job)
+{
+	// Counted before it is visible, a worker going to sleep either sees it or is woken up below
+	queued.fetch_add(1);
+	if (!threadData[GetThreadIndex()]->queue.Push(job))
+	{
+		queued.fetch_sub(1);
+		Execute(job);
+		return;
+	}
+
+	if (sleeping.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		wakeUp.notify_one();
+	}
+}
+
+bool JobSystem::RunOne()
+{
+	const uint index = GetThreadIndex();
+	ThreadData& self = *threadData[index];
+
+	Job* job = self.queue.Pop();
+	if (job == nullptr)
+	{
+		// Victims are visited in turns so the same one is not always hit first
+		const uint numThreads = (uint)threadData.size();
+		for (uint i = 1; i < numThreads && job == nullptr; ++i)
+			job = threadData[(index + self.nextVictim + i) % numThreads]->queue.Steal();
+		++self.nextVictim;
+
+		if (job == nullptr)
+			return false;
+		self.stolen.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	queued.fetch_sub(1);
+	Execute(job);
+	self.executed.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void JobSystem::Execute(Job* job)
+{
+	PROFILE_ZONE("Job");
+	job->task();
+
+	// Free the slot before the counter lets anyone go on, nothing in the job is read after this
+	JobCounter* counter = job->counter;
+	job->inFlight.store(false, std::memory_order_release);
+	Finish(counter);
+}
+
+void JobSystem::Finish(JobCounter* counter)
+{
+	if (counter == nullptr)
+		return;
+
+	// Decremented under the lock so a waiter never frees the counter while it is still in use here
+	std::vector<Job*> ready;
+	{
+		std::lock_guard<std::mutex> lock(counter->mutex);
+		if (counter->pending.fetch_sub(1) == 1)
+			ready.swap(counter->continuations);
+	}
+
+	for (Job* job : ready)
+		Push(job);
+}
+
+uint JobSystem::GetThreadIndex() const
+{
+	return threadIndex;
+}
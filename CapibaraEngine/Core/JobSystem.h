@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Globals.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+#define JOB_SYSTEM_QUEUE_SIZE 4096 // Jobs per thread deque, power of two. A full deque runs the job in place
+#define JOB_SYSTEM_MAX_JOBS 4096 // Jobs in flight per thread, their storage is recycled in a ring. Past it jobs run in place
+#define JOB_SYSTEM_JOBS_PER_THREAD 4 // Parallel for ranges per thread, so faster threads can steal the rest
+#define JOB_SYSTEM_SPIN_COUNT 64 // Failed steals before an idle worker goes to sleep
+
+struct Job;
+
+// Counts the jobs still running in a group. Jobs can wait on a counter or be queued to start when it gets to zero.
+class JobCounter
+{
+public:
+	JobCounter() : pending(0) {}
+
+	inline bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+
+	std::atomic<uint> pending;
+	std::mutex mutex; // Guards the continuations
+	std::vector<Job*> continuations;
+};
+
+struct Job
+{
+	std::function<void()> task;
+	JobCounter* counter = nullptr;
+	std::atomic<bool> inFlight; // From allocation until the task returns, the slot is not reused meanwhile
+
+	Job() : inFlight(false) {}
+};
+
+// Chase-Lev deque. The owner thread pushes and pops at the bottom, any other thread steals from the top.
+class JobQueue
+{
+public:
+	JobQueue();
+
+	bool Push(Job* job); // Owner only, false when full
+	Job* Pop(); // Owner only
+	Job* Steal();
+
+private:
+	std::atomic<long long> top;
+	std::atomic<long long> bottom;
+	std::atomic<Job*> jobs[JOB_SYSTEM_QUEUE_SIZE];
+};
+
+struct JobThreadStats
+{
+	uint executed = 0;
+	uint stolen = 0;
+};
+
+// Work stealing job system. Every thread, the main one included, owns a deque. New jobs go to the
+// deque of the thread that creates them and idle threads steal from the others. Waiting on a counter
+// runs jobs instead of blocking, so jobs can wait on the jobs they spawn. In single thread mode every
+// job runs in place when it is created, in the same order every time, for debugging.
+class JobSystem
+{
+public:
+	JobSystem();
+	~JobSystem();
+
+	void Start(uint numWorkers); // Must be called from the main thread
+	void Stop();
+
+	// The counter, if any, is incremented now and decremented once the task has run
+	void Run(const std::function<void()>& task, JobCounter* counter = nullptr);
+	// Queued once the dependency gets to zero, right away if it already is
+	void RunAfter(JobCounter& dependency, const std::function<void()>& task, JobCounter* counter = nullptr);
+	// Runs other jobs until the counter gets to zero
+	void Wait(JobCounter& counter);
+	// Runs one queued job, from this thread deque or stolen, false if there was none
+	bool RunOne();
+
+	// Calls task(i) for every i in [0, count) and returns once all of them are done. Indices are
+	// split in contiguous ranges, a few per thread.
+	void ParallelFor(uint count, const std::function<void(uint)>& task);
+
+	inline uint GetNumWorkers() const { return (uint)workers.size(); }
+	inline uint GetNumThreads() const { return (uint)workers.size() + 1; } // Workers plus the main thread
+
+	void SetSingleThreaded(bool singleThreaded); // Only between jobs, from the main thread
+	inline bool IsSingleThreaded() const { return singleThreaded; }
+
+	// Per thread counts since the last call, the main thread first
+	void GetStats(std::vector<JobThreadStats>& stats);
+
+private:
+	struct ThreadData
+	{
+		JobQueue queue;
+		Job jobs[JOB_SYSTEM_MAX_JOBS];
+		uint nextJob = 0;
+		std::atomic<uint> executed;
+		std::atomic<uint> stolen;
+		uint nextVictim = 0;
+
+		ThreadData() : executed(0), stolen(0) {}
+	};
+
+	void WorkerLoop(uint index);
+
+	Job* AllocateJob(const std::function<void()>& task, JobCounter* counter); // nullptr if the next slot is still in flight
+	void Push(Job* job);
+	void Execute(Job* job);
+	void Finish(JobCounter* counter);
+
+	uint GetThreadIndex() const;
+
+private:
+	std::vector<ThreadData*> threadData; // Index 0 is the main thread
+	std::vector<std::thread> workers;
+
+	std::atomic<uint> queued; // Jobs sitting in any deque
+	std::atomic<uint> sleeping;
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+	bool stopping = false;
+	bool singleThreaded = false;
+};
@@ -33,7 +33,7 @@ int main(int argc, char ** argv)
 		case MAIN_CREATION:
 
 			LOG("-------------- Application Creation --------------");
-			App = new Application();
+			App = new Application(argc, argv);
 			state = MAIN_START;
 			break;
 
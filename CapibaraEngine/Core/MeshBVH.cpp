@@ -0,0 +1,309 @@
+#include "MeshBVH.h"
+#include "Math/MathConstants.h"
+
+#include <algorithm>
+
+#define MESH_BVH_MAX_DEPTH 64
+
+static inline float HalfArea(const float3& minPoint, const float3& maxPoint)
+{
+	const float3 size = maxPoint - minPoint;
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+void MeshBVH::Clear()
+{
+	nodes.clear();
+	triangles.clear();
+}
+
+void MeshBVH::Build(const std::vector<float3>& vertices, const std::vector<uint>& indices)
+{
+	Clear();
+
+	const uint numTriangles = (uint)indices.size() / 3;
+	if (numTriangles == 0)
+		return;
+
+	// Per triangle bounds and centroids, only needed while building
+	std::vector<float3> triangleMin(numTriangles), triangleMax(numTriangles), centroids(numTriangles);
+	triangles.resize(numTriangles);
+	for (uint i = 0; i < numTriangles; ++i)
+	{
+		const float3& a = vertices[indices[i * 3]];
+		const float3& b = vertices[indices[i * 3 + 1]];
+		const float3& c = vertices[indices[i * 3 + 2]];
+		triangleMin[i] = a.Min(b).Min(c);
+		triangleMax[i] = a.Max(b).Max(c);
+		centroids[i] = (a + b + c) / 3.f;
+		triangles[i] = i;
+	}
+
+	auto computeBounds = [&](MeshBVHNode& node)
+	{
+		node.minPoint = float3(FLOAT_INF, FLOAT_INF, FLOAT_INF);
+		node.maxPoint = float3(-FLOAT_INF, -FLOAT_INF, -FLOAT_INF);
+		for (uint i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i)
+		{
+			node.minPoint = node.minPoint.Min(triangleMin[triangles[i]]);
+			node.maxPoint = node.maxPoint.Max(triangleMax[triangles[i]]);
+		}
+	};
+
+	nodes.reserve(numTriangles * 2);
+	MeshBVHNode root;
+	root.leftOrFirst = 0;
+	root.count = numTriangles;
+	computeBounds(root);
+	nodes.push_back(root);
+
+	// Node index and depth, depth is capped so the traversal stack can live on the stack
+	std::vector<std::pair<uint, uint>> pending;
+	pending.push_back(std::make_pair(0u, 1u));
+
+	while (!pending.empty())
+	{
+		const uint nodeIndex = pending.back().first;
+		const uint depth = pending.back().second;
+		pending.pop_back();
+
+		const uint first = nodes[nodeIndex].leftOrFirst;
+		const uint count = nodes[nodeIndex].count;
+		if (count <= MESH_BVH_LEAF_TRIANGLES || depth >= MESH_BVH_MAX_DEPTH)
+			continue;
+
+		// Split along the longest axis of the centroid bounds
+		float3 centroidMin = centroids[triangles[first]];
+		float3 centroidMax = centroidMin;
+		for (uint i = first + 1; i < first + count; ++i)
+		{
+			centroidMin = centroidMin.Min(centroids[triangles[i]]);
+			centroidMax = centroidMax.Max(centroids[triangles[i]]);
+		}
+
+		const float3 extent = centroidMax - centroidMin;
+		const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+		if (extent[axis] <= 0.f)
+			continue;
+
+		// Binned surface area heuristic
+		uint binCount[MESH_BVH_BINS] = {};
+		float3 binMin[MESH_BVH_BINS], binMax[MESH_BVH_BINS];
+		for (int b = 0; b < MESH_BVH_BINS; ++b)
+		{
+			binMin[b] = float3(FLOAT_INF, FLOAT_INF, FLOAT_INF);
+			binMax[b] = float3(-FLOAT_INF, -FLOAT_INF, -FLOAT_INF);
+		}
+
+		const float scale = MESH_BVH_BINS / extent[axis];
+		auto binOf = [&](uint triangle)
+		{
+			const int bin = (int)((centroids[triangle][axis] - centroidMin[axis]) * scale);
+			return bin < MESH_BVH_BINS - 1 ? bin : MESH_BVH_BINS - 1;
+		};
+
+		for (uint i = first; i < first + count; ++i)
+		{
+			const uint triangle = triangles[i];
+			const int bin = binOf(triangle);
+			++binCount[bin];
+			binMin[bin] = binMin[bin].Min(triangleMin[triangle]);
+			binMax[bin] = binMax[bin].Max(triangleMax[triangle]);
+		}
+
+		float leftCost[MESH_BVH_BINS - 1];
+		float3 sweepMin(FLOAT_INF, FLOAT_INF, FLOAT_INF), sweepMax(-FLOAT_INF, -FLOAT_INF, -FLOAT_INF);
+		uint sweepCount = 0;
+		for (int b = 0; b < MESH_BVH_BINS - 1; ++b)
+		{
+			sweepCount += binCount[b];
+			sweepMin = sweepMin.Min(binMin[b]);
+			sweepMax = sweepMax.Max(binMax[b]);
+			leftCost[b] = sweepCount ? sweepCount * HalfArea(sweepMin, sweepMax) : 0.f;
+		}
+
+		int bestSplit = -1;
+		float bestCost = count * HalfArea(nodes[nodeIndex].minPoint, nodes[nodeIndex].maxPoint); // Cost of keeping a leaf
+		sweepMin = float3(FLOAT_INF, FLOAT_INF, FLOAT_INF);
+		sweepMax = float3(-FLOAT_INF, -FLOAT_INF, -FLOAT_INF);
+		sweepCount = 0;
+		for (int b = MESH_BVH_BINS - 1; b > 0; --b)
+		{
+			sweepCount += binCount[b];
+			sweepMin = sweepMin.Min(binMin[b]);
+			sweepMax = sweepMax.Max(binMax[b]);
+			const float cost = leftCost[b - 1] + (sweepCount ? sweepCount * HalfArea(sweepMin, sweepMax) : 0.f);
+			if (cost < bestCost && sweepCount != count)
+			{
+				bestCost = cost;
+				bestSplit = b - 1;
+			}
+		}
+
+		if (bestSplit < 0)
+			continue;
+
+		uint* middle = std::partition(&triangles[first], &triangles[first] + count, [&](uint triangle) { return binOf(triangle) <= bestSplit; });
+		const uint leftCount = (uint)(middle - &triangles[first]);
+		if (leftCount == 0 || leftCount == count)
+			continue;
+
+		const uint leftIndex = (uint)nodes.size();
+		MeshBVHNode left, right;
+		left.leftOrFirst = first;
+		left.count = leftCount;
+		right.leftOrFirst = first + leftCount;
+		right.count = count - leftCount;
+		computeBounds(left);
+		computeBounds(right);
+		nodes.push_back(left);
+		nodes.push_back(right);
+
+		nodes[nodeIndex].leftOrFirst = leftIndex;
+		nodes[nodeIndex].count = 0;
+
+		pending.push_back(std::make_pair(leftIndex, depth + 1));
+		pending.push_back(std::make_pair(leftIndex + 1, depth + 1));
+	}
+
+	nodes.shrink_to_fit();
+}
+
+bool MeshBVH::IsValid(uint numTriangles) const
+{
+	if (nodes.empty())
+		return triangles.empty();
+
+	for (uint triangle : triangles)
+	{
+		if (triangle >= numTriangles)
+			return false;
+	}
+
+	// Children are always stored after their parent, so one pass in order knows every depth
+	std::vector<uint> depths(nodes.size(), 0);
+	depths[0] = 1;
+	for (uint i = 0; i < nodes.size(); ++i)
+	{
+		const MeshBVHNode& node = nodes[i];
+		if (depths[i] == 0 || depths[i] > MESH_BVH_MAX_DEPTH)
+			return false;
+
+		if (node.IsLeaf())
+		{
+			if (node.leftOrFirst > triangles.size() || node.count > triangles.size() - node.leftOrFirst)
+				return false;
+		}
+		else
+		{
+			if (node.leftOrFirst <= i || node.leftOrFirst + 1 >= nodes.size())
+				return false;
+			depths[node.leftOrFirst] = std::max(depths[node.leftOrFirst], depths[i] + 1);
+			depths[node.leftOrFirst + 1] = std::max(depths[node.leftOrFirst + 1], depths[i] + 1);
+		}
+	}
+	return true;
+}
+
+// Entry distance of the ray into the node, FLOAT_INF on a miss or beyond maxDistance
+static inline float IntersectNode(const MeshBVHNode& node, const float3& origin, const float3& invDir, float maxDistance)
+{
+	const float3 t0 = (node.minPoint - origin).Mul(invDir);
+	const float3 t1 = (node.maxPoint - origin).Mul(invDir);
+	const float3 tMin = t0.Min(t1);
+	const float3 tMax = t0.Max(t1);
+
+	const float enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.f));
+	const float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+	return enter <= exit ? enter : FLOAT_INF;
+}
+
+bool MeshBVH::RayCast(const LineSegment& segment, const std::vector<float3>& vertices, const std::vector<uint>& indices, float maxDistance, float& distance) const
+{
+	if (nodes.empty())
+		return false;
+
+	const float3 origin = segment.a;
+	const float length = segment.Length();
+	if (length <= 0.f)
+		return false;
+
+	const float3 dir = (segment.b - segment.a) / length;
+	const float3 invDir(1.f / dir.x, 1.f / dir.y, 1.f / dir.z);
+
+	// Work in local units along the ray, converted back to the normalized distance at the end
+	float best = std::min(maxDistance, 1.f) * length;
+	bool hit = false;
+
+	struct Entry { uint node; float distance; };
+	Entry stack[MESH_BVH_MAX_DEPTH + 1]; // Depth first, never deeper than the build allowed
+	int top = 0;
+
+	const float rootDistance = IntersectNode(nodes[0], origin, invDir, best);
+	if (rootDistance == FLOAT_INF)
+		return false;
+	stack[top++] = { 0u, rootDistance };
+
+	while (top > 0)
+	{
+		const Entry entry = stack[--top];
+		if (entry.distance >= best)
+			continue;
+
+		const MeshBVHNode& node = nodes[entry.node];
+		if (node.IsLeaf())
+		{
+			// Moller-Trumbore, both faces count like Triangle::Intersects
+			for (uint i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i)
+			{
+				const uint triangle = triangles[i] * 3;
+				const float3& a = vertices[indices[triangle]];
+				const float3 edge1 = vertices[indices[triangle + 1]] - a;
+				const float3 edge2 = vertices[indices[triangle + 2]] - a;
+
+				const float3 p = dir.Cross(edge2);
+				const float det = edge1.Dot(p);
+				if (det > -1e-8f && det < 1e-8f)
+					continue;
+
+				const float invDet = 1.f / det;
+				const float3 s = origin - a;
+				const float u = s.Dot(p) * invDet;
+				if (u < 0.f || u > 1.f)
+					continue;
+
+				const float3 q = s.Cross(edge1);
+				const float v = dir.Dot(q) * invDet;
+				if (v < 0.f || u + v > 1.f)
+					continue;
+
+				const float t = edge2.Dot(q) * invDet;
+				if (t >= 0.f && t < best)
+				{
+					best = t;
+					hit = true;
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first, the other one is usually pruned by then
+		const uint left = node.leftOrFirst;
+		const float leftDistance = IntersectNode(nodes[left], origin, invDir, best);
+		const float rightDistance = IntersectNode(nodes[left + 1], origin, invDir, best);
+
+		const bool leftFirst = leftDistance <= rightDistance;
+		const Entry nearEntry = { leftFirst ? left : left + 1, leftFirst ? leftDistance : rightDistance };
+		const Entry farEntry = { leftFirst ? left + 1 : left, leftFirst ? rightDistance : leftDistance };
+
+		if (farEntry.distance != FLOAT_INF)
+			stack[top++] = farEntry;
+		if (nearEntry.distance != FLOAT_INF)
+			stack[top++] = nearEntry;
+	}
+
+	if (hit)
+		distance = best / length;
+
+	return hit;
+}
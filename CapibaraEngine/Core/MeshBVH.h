@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Globals.h"
+#include "Math/float3.h"
+#include "Geometry/LineSegment.h"
+#include <vector>
+
+#define MESH_BVH_LEAF_TRIANGLES 4
+#define MESH_BVH_BINS 12
+
+// 32 bytes, children of an inner node are stored next to each other
+struct MeshBVHNode
+{
+	float3 minPoint;
+	uint leftOrFirst; // Left child for inner nodes, first triangle for leaves
+	float3 maxPoint;
+	uint count; // Triangles in the leaf, 0 for inner nodes
+
+	inline bool IsLeaf() const { return count != 0; }
+};
+
+// Triangle bounding volume hierarchy of a mesh in local space, built with binned SAH.
+// Stored in the binary mesh cache so picking never has to test every triangle.
+class MeshBVH
+{
+public:
+	void Build(const std::vector<float3>& vertices, const std::vector<uint>& indices);
+	void Clear();
+
+	// Closest hit along the segment, distance is normalized to the segment length like MathGeoLib.
+	// Only hits closer than maxDistance count, so several meshes can share the best hit so far.
+	bool RayCast(const LineSegment& segment, const std::vector<float3>& vertices, const std::vector<uint>& indices, float maxDistance, float& distance) const;
+
+	// Every child, leaf range and triangle id in range and no deeper than the build goes, for data
+	// that comes from a file
+	bool IsValid(uint numTriangles) const;
+
+	inline bool IsEmpty() const { return nodes.empty(); }
+
+	std::vector<MeshBVHNode> nodes;
+	std::vector<uint> triangles; // Triangle ids ordered by leaf
+};
@@ -0,0 +1,342 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <math.h>
+
+#define INVALID_INDEX 0xffffffff
+#define MAX_SCORED_VALENCE 32
+
+// Forsyth's scores, vertices just used stay hot and lonely vertices are finished off first
+struct VertexScoreTable
+{
+	float cache[MESH_OPTIMIZER_CACHE_SIZE];
+	float valence[MAX_SCORED_VALENCE];
+
+	VertexScoreTable()
+	{
+		for (uint i = 0; i < MESH_OPTIMIZER_CACHE_SIZE; ++i)
+			cache[i] = i < 3 ? 0.75f : powf(1.f - (float)(i - 3) / (MESH_OPTIMIZER_CACHE_SIZE - 3), 1.5f);
+		for (uint i = 0; i < MAX_SCORED_VALENCE; ++i)
+			valence[i] = i > 0 ? 2.f / sqrtf((float)i) : 0.f;
+	}
+
+	float Score(int cachePosition, uint remainingTriangles) const
+	{
+		if (remainingTriangles == 0)
+			return -1.f;
+
+		const float cacheScore = cachePosition >= 0 && cachePosition < MESH_OPTIMIZER_CACHE_SIZE ? cache[cachePosition] : 0.f;
+		return cacheScore + valence[std::min(remainingTriangles, (uint)MAX_SCORED_VALENCE - 1)];
+	}
+};
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint>& indices, uint numVertices)
+{
+	static const VertexScoreTable scores;
+
+	const uint numTriangles = (uint)indices.size() / 3;
+	if (numTriangles == 0 || numVertices == 0)
+		return;
+
+	// Triangles around every vertex, the used ones are swapped past the remaining count
+	std::vector<uint> remaining(numVertices, 0);
+	for (uint i = 0; i < numTriangles * 3; ++i)
+		++remaining[indices[i]];
+
+	std::vector<uint> firstTriangle(numVertices + 1, 0);
+	for (uint v = 0; v < numVertices; ++v)
+		firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+
+	std::vector<uint> adjacency(numTriangles * 3);
+	std::vector<uint> filled(numVertices, 0);
+	for (uint i = 0; i < numTriangles * 3; ++i)
+	{
+		const uint v = indices[i];
+		adjacency[firstTriangle[v] + filled[v]++] = i / 3;
+	}
+
+	std::vector<int> cachePosition(numVertices, -1);
+	std::vector<float> vertexScore(numVertices);
+	for (uint v = 0; v < numVertices; ++v)
+		vertexScore[v] = scores.Score(-1, remaining[v]);
+
+	std::vector<float> triangleScore(numTriangles);
+	std::vector<bool> emitted(numTriangles, false);
+	for (uint t = 0; t < numTriangles; ++t)
+		triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+	std::vector<uint> destination;
+	destination.reserve(numTriangles * 3);
+
+	// Three extra slots hold the vertices pushed out by the last triangle until their scores drop
+	std::vector<uint> cache, nextCache;
+	cache.reserve(MESH_OPTIMIZER_CACHE_SIZE + 3);
+	nextCache.reserve(MESH_OPTIMIZER_CACHE_SIZE + 3);
+
+	uint bestTriangle = (uint)(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+	uint scanCursor = 0;
+
+	while (destination.size() < numTriangles * 3)
+	{
+		// Nothing left around the cache, start over from the next triangle still waiting
+		if (bestTriangle == INVALID_INDEX)
+		{
+			while (emitted[scanCursor])
+				++scanCursor;
+			bestTriangle = scanCursor;
+		}
+
+		const uint* triangle = &indices[bestTriangle * 3];
+		destination.insert(destination.end(), triangle, triangle + 3);
+		emitted[bestTriangle] = true;
+
+		nextCache.clear();
+		for (uint corner = 0; corner < 3; ++corner)
+		{
+			const uint v = triangle[corner];
+
+			uint* begin = &adjacency[firstTriangle[v]];
+			uint* end = begin + remaining[v];
+			uint* used = std::find(begin, end, bestTriangle);
+			if (used != end)
+			{
+				std::swap(*used, *(end - 1));
+				--remaining[v];
+			}
+
+			if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end())
+				nextCache.push_back(v);
+		}
+		for (uint v : cache)
+		{
+			if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end())
+				nextCache.push_back(v);
+		}
+
+		// New positions and scores, pushed triangle scores along
+		for (uint i = 0; i < nextCache.size(); ++i)
+		{
+			const uint v = nextCache[i];
+			cachePosition[v] = i < MESH_OPTIMIZER_CACHE_SIZE ? (int)i : -1;
+
+			const float score = scores.Score(cachePosition[v], remaining[v]);
+			const float delta = score - vertexScore[v];
+			vertexScore[v] = score;
+
+			for (uint j = 0; j < remaining[v]; ++j)
+				triangleScore[adjacency[firstTriangle[v] + j]] += delta;
+		}
+
+		// Only triangles touching the cache are worth looking at
+		bestTriangle = INVALID_INDEX;
+		float bestScore = -1.f;
+		for (uint i = 0; i < nextCache.size() && i < MESH_OPTIMIZER_CACHE_SIZE; ++i)
+		{
+			const uint v = nextCache[i];
+			for (uint j = 0; j < remaining[v]; ++j)
+			{
+				const uint t = adjacency[firstTriangle[v] + j];
+				if (triangleScore[t] > bestScore)
+				{
+					bestScore = triangleScore[t];
+					bestTriangle = t;
+				}
+			}
+		}
+
+		if (nextCache.size() > MESH_OPTIMIZER_CACHE_SIZE)
+			nextCache.resize(MESH_OPTIMIZER_CACHE_SIZE);
+		cache.swap(nextCache);
+	}
+
+	// Any trailing indices that don't make a triangle stay where they were
+	std::copy(destination.begin(), destination.end(), indices.begin());
+}
+
+// Triangle ranges, hard boundaries where the FIFO cache starts over and, if asked, soft ones as soon
+// as a cluster reaches the target miss ratio on its own
+static void BuildClusters(const std::vector<uint>& indices, uint numVertices, float targetAcmr, bool softBoundaries, std::vector<uint>& clusters)
+{
+	clusters.clear();
+
+	const uint numTriangles = (uint)indices.size() / 3;
+	std::vector<uint> cacheTime(numVertices, 0);
+	uint time = MESH_OPTIMIZER_FIFO_SIZE + 1;
+
+	uint clusterStart = 0, clusterMisses = 0;
+	for (uint t = 0; t < numTriangles; ++t)
+	{
+		uint misses = 0;
+		for (uint corner = 0; corner < 3; ++corner)
+		{
+			const uint v = indices[t * 3 + corner];
+			if (time - cacheTime[v] > MESH_OPTIMIZER_FIFO_SIZE)
+			{
+				cacheTime[v] = time++;
+				++misses;
+			}
+		}
+
+		if (t == 0 || misses == 3)
+		{
+			clusters.push_back(t);
+			clusterStart = t;
+			clusterMisses = 0;
+		}
+		clusterMisses += misses;
+
+		// Soft clusters are measured from a cold cache, so they are large enough to pay for their first triangles
+		if (softBoundaries && t + 1 < numTriangles && clusterMisses <= targetAcmr * (t + 1 - clusterStart))
+		{
+			clusters.push_back(t + 1);
+			clusterStart = t + 1;
+			clusterMisses = 0;
+			time += MESH_OPTIMIZER_FIFO_SIZE + 1;
+		}
+	}
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint>& indices, const std::vector<float3>& vertices, float threshold)
+{
+	const uint numVertices = (uint)vertices.size();
+	const uint numTriangles = (uint)indices.size() / 3;
+	if (numTriangles < 2 || numVertices == 0)
+		return;
+
+	const float inputAcmr = AnalyzeVertexCache(indices, numVertices).acmr;
+
+	// Area weighted center of the whole mesh
+	float3 meshCenter = float3::zero;
+	float meshArea = 0.f;
+	for (uint t = 0; t < numTriangles; ++t)
+	{
+		const float3& a = vertices[indices[t * 3]];
+		const float3& b = vertices[indices[t * 3 + 1]];
+		const float3& c = vertices[indices[t * 3 + 2]];
+		const float area = (b - a).Cross(c - a).Length();
+		meshCenter += (a + b + c) * (area / 3.f);
+		meshArea += area;
+	}
+	if (meshArea <= 0.f)
+		return;
+	meshCenter /= meshArea;
+
+	struct Cluster
+	{
+		uint first;
+		uint count;
+		float sortKey;
+
+		bool operator<(const Cluster& other) const { return sortKey > other.sortKey; }
+	};
+
+	std::vector<uint> boundaries;
+	std::vector<Cluster> clusters;
+	std::vector<uint> sorted(indices.size());
+
+	// Fine clusters first, the hard boundaries alone if those break the cache order too much
+	for (uint attempt = 0; attempt < 2; ++attempt)
+	{
+		BuildClusters(indices, numVertices, inputAcmr * threshold, attempt == 0, boundaries);
+		if (boundaries.size() < 2)
+			return;
+
+		// Clusters facing away from the middle of the mesh are the ones in front, they go first
+		clusters.clear();
+		for (uint i = 0; i < boundaries.size(); ++i)
+		{
+			Cluster cluster;
+			cluster.first = boundaries[i];
+			cluster.count = (i + 1 < boundaries.size() ? boundaries[i + 1] : numTriangles) - cluster.first;
+
+			float3 center = float3::zero, normal = float3::zero;
+			float area = 0.f;
+			for (uint t = cluster.first; t < cluster.first + cluster.count; ++t)
+			{
+				const float3& a = vertices[indices[t * 3]];
+				const float3& b = vertices[indices[t * 3 + 1]];
+				const float3& c = vertices[indices[t * 3 + 2]];
+				const float3 cross = (b - a).Cross(c - a);
+				const float triangleArea = cross.Length();
+				center += (a + b + c) * (triangleArea / 3.f);
+				normal += cross;
+				area += triangleArea;
+			}
+
+			cluster.sortKey = 0.f;
+			if (area > 0.f && normal.LengthSq() > 0.f)
+				cluster.sortKey = (center / area - meshCenter).Dot(normal.Normalized());
+			clusters.push_back(cluster);
+		}
+
+		std::stable_sort(clusters.begin(), clusters.end());
+
+		uint* cursor = &sorted[0];
+		for (const Cluster& cluster : clusters)
+		{
+			std::copy(&indices[cluster.first * 3], &indices[(cluster.first + cluster.count) * 3], cursor);
+			cursor += cluster.count * 3;
+		}
+		std::copy(indices.begin() + numTriangles * 3, indices.end(), cursor);
+
+		if (AnalyzeVertexCache(sorted, numVertices).acmr <= inputAcmr * threshold)
+		{
+			indices.swap(sorted);
+			return;
+		}
+	}
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<uint>& indices, uint numVertices, std::vector<uint>& remap)
+{
+	remap.assign(numVertices, INVALID_INDEX);
+
+	uint next = 0;
+	for (uint index : indices)
+	{
+		if (remap[index] == INVALID_INDEX)
+			remap[index] = next++;
+	}
+	for (uint v = 0; v < numVertices; ++v)
+	{
+		if (remap[v] == INVALID_INDEX)
+			remap[v] = next++;
+	}
+
+	for (uint& index : indices)
+		index = remap[index];
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<uint>& indices, uint numVertices, uint cacheSize)
+{
+	VertexCacheStats stats;
+
+	const uint numTriangles = (uint)indices.size() / 3;
+	if (numTriangles == 0 || numVertices == 0)
+		return stats;
+
+	// A vertex is still cached while fewer than cacheSize others were transformed after it
+	std::vector<uint> cacheTime(numVertices, 0);
+	std::vector<bool> referenced(numVertices, false);
+	uint time = cacheSize + 1;
+	uint misses = 0, unique = 0;
+
+	for (uint i = 0; i < numTriangles * 3; ++i)
+	{
+		const uint v = indices[i];
+		if (time - cacheTime[v] > cacheSize)
+		{
+			cacheTime[v] = time++;
+			++misses;
+		}
+		if (!referenced[v])
+		{
+			referenced[v] = true;
+			++unique;
+		}
+	}
+
+	stats.acmr = (float)misses / numTriangles;
+	stats.atvr = (float)misses / unique;
+	return stats;
+}
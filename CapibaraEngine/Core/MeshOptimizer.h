@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Globals.h"
+#include "Math/float3.h"
+#include <vector>
+
+#define MESH_OPTIMIZER_CACHE_SIZE 32 // LRU cache the triangle order is tuned for
+#define MESH_OPTIMIZER_FIFO_SIZE 16 // FIFO cache the statistics are measured with, typical of current GPUs
+#define MESH_OPTIMIZER_OVERDRAW_THRESHOLD 1.05f // Overdraw order may cost up to 5% more cache misses
+
+// Post-transform vertex cache efficiency of an index buffer
+struct VertexCacheStats
+{
+	float acmr = 0.f; // Average cache miss ratio, transformed vertices per triangle (0.5 best, 3 worst)
+	float atvr = 0.f; // Average transform to vertex ratio, transformed vertices per referenced vertex (1 best)
+};
+
+// Index and vertex buffer reordering, run once after import. None of it changes what is drawn.
+namespace MeshOptimizer
+{
+	// Triangle order for vertex cache reuse, Tom Forsyth's linear-speed algorithm
+	void OptimizeVertexCache(std::vector<uint>& indices, uint numVertices);
+
+	// Sorts cache friendly clusters of triangles front to back seen from outside the mesh, so the
+	// outer surfaces hide the inner ones. Keeps the input order when it costs too many cache misses.
+	void OptimizeOverdraw(std::vector<uint>& indices, const std::vector<float3>& vertices, float threshold = MESH_OPTIMIZER_OVERDRAW_THRESHOLD);
+
+	// Vertex order of first use so vertex fetch walks the buffer forward. Rewrites the indices and
+	// fills remap with the new position of every old vertex, unused vertices go last.
+	void OptimizeVertexFetch(std::vector<uint>& indices, uint numVertices, std::vector<uint>& remap);
+
+	VertexCacheStats AnalyzeVertexCache(const std::vector<uint>& indices, uint numVertices, uint cacheSize = MESH_OPTIMIZER_FIFO_SIZE);
+
+	// Moves every element to its remapped position
+	template <typename T>
+	void RemapVertices(std::vector<T>& data, const std::vector<uint>& remap)
+	{
+		if (data.size() != remap.size())
+			return;
+
+		std::vector<T> remapped(data.size());
+		for (size_t i = 0; i < data.size(); ++i)
+			remapped[remap[i]] = data[i];
+		data.swap(remapped);
+	}
+}
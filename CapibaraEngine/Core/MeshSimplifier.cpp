@@ -0,0 +1,271 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <string.h>
+#include <math.h>
+
+// Symmetric 4x4 plane quadric, doubles so large flat areas don't lose the small errors
+struct Quadric
+{
+	double a2 = 0, b2 = 0, c2 = 0, d2 = 0;
+	double ab = 0, ac = 0, ad = 0, bc = 0, bd = 0, cd = 0;
+	double weight = 0;
+
+	void AddPlane(double a, double b, double c, double d, double weight)
+	{
+		this->weight += weight;
+		a2 += a * a * weight; b2 += b * b * weight; c2 += c * c * weight; d2 += d * d * weight;
+		ab += a * b * weight; ac += a * c * weight; ad += a * d * weight;
+		bc += b * c * weight; bd += b * d * weight; cd += c * d * weight;
+	}
+
+	void Add(const Quadric& other)
+	{
+		a2 += other.a2; b2 += other.b2; c2 += other.c2; d2 += other.d2;
+		ab += other.ab; ac += other.ac; ad += other.ad; bc += other.bc; bd += other.bd; cd += other.cd;
+		weight += other.weight;
+	}
+
+	// Mean squared distance to the planes
+	double Error(const float3& p) const
+	{
+		const double x = p.x, y = p.y, z = p.z;
+		const double error = a2 * x * x + b2 * y * y + c2 * z * z + d2
+			+ 2.0 * (ab * x * y + ac * x * z + ad * x + bc * y * z + bd * y + cd * z);
+		return error > 0.0 && weight > 0.0 ? error / weight : 0.0;
+	}
+};
+
+struct Collapse
+{
+	uint from;
+	uint to;
+	float cost;
+
+	bool operator<(const Collapse& other) const { return cost < other.cost; }
+};
+
+struct PositionHash
+{
+	size_t operator()(const float3& p) const
+	{
+		uint bits[3];
+		memcpy(bits, &p, sizeof(bits));
+		return (size_t)(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+	}
+};
+
+struct PositionEqual
+{
+	bool operator()(const float3& a, const float3& b) const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+};
+
+static inline bool IsDegenerate(const uint* triangle)
+{
+	return triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2];
+}
+
+float MeshSimplifier::Simplify(const std::vector<float3>& vertices, const std::vector<uint>& indices, uint targetIndexCount, float targetError, std::vector<uint>& destination)
+{
+	destination = indices;
+	const uint numVertices = (uint)vertices.size();
+	if (indices.size() <= targetIndexCount || numVertices == 0)
+		return 0.f;
+
+	// Errors are measured on positions scaled to the unit cube
+	float3 minPoint = vertices[0], maxPoint = vertices[0];
+	for (const float3& v : vertices)
+	{
+		minPoint = minPoint.Min(v);
+		maxPoint = maxPoint.Max(v);
+	}
+	const float3 size = maxPoint - minPoint;
+	const float extent = size.MaxElement() > 0.f ? size.MaxElement() : 1.f;
+	std::vector<float3> positions(numVertices);
+	for (uint i = 0; i < numVertices; ++i)
+		positions[i] = (vertices[i] - minPoint) / extent;
+
+	// Vertices split by a seam share a position, each group has a first vertex and a count
+	std::vector<uint> firstOfPosition(numVertices);
+	std::vector<uint> positionCount(numVertices, 0);
+	{
+		std::unordered_map<float3, uint, PositionHash, PositionEqual> firstVertex;
+		firstVertex.reserve(numVertices);
+		for (uint i = 0; i < numVertices; ++i)
+		{
+			auto it = firstVertex.insert(std::make_pair(vertices[i], i)).first;
+			firstOfPosition[i] = it->second;
+			++positionCount[it->second];
+		}
+	}
+
+	// Seam vertices and the ones on open borders can't move, the border test counts each edge
+	// between positions, an edge used by a single triangle is a border
+	std::vector<bool> locked(numVertices, false);
+	for (uint i = 0; i < numVertices; ++i)
+		locked[i] = positionCount[firstOfPosition[i]] > 1;
+	{
+		std::unordered_map<uint64, uint> edgeUses;
+		edgeUses.reserve(indices.size());
+		for (size_t t = 0; t + 2 < indices.size(); t += 3)
+		{
+			for (int e = 0; e < 3; ++e)
+			{
+				uint a = firstOfPosition[indices[t + e]], b = firstOfPosition[indices[t + (e + 1) % 3]];
+				if (a > b) std::swap(a, b);
+				++edgeUses[((uint64)a << 32) | b];
+			}
+		}
+		for (const auto& edge : edgeUses)
+		{
+			if (edge.second == 1)
+			{
+				locked[(uint)(edge.first >> 32)] = true;
+				locked[(uint)(edge.first & 0xFFFFFFFF)] = true;
+			}
+		}
+		for (uint i = 0; i < numVertices; ++i)
+			locked[i] = locked[i] || locked[firstOfPosition[i]];
+	}
+
+	// Area weighted plane of every triangle, added to its three corners
+	std::vector<Quadric> quadrics(numVertices);
+	for (size_t t = 0; t + 2 < indices.size(); t += 3)
+	{
+		const float3& p0 = positions[indices[t]];
+		const float3& p1 = positions[indices[t + 1]];
+		const float3& p2 = positions[indices[t + 2]];
+		float3 normal = (p1 - p0).Cross(p2 - p0);
+		const float area = normal.Length();
+		if (area <= 0.f)
+			continue;
+		normal /= area;
+		const double d = -(double)normal.Dot(p0);
+		for (int c = 0; c < 3; ++c)
+			quadrics[indices[t + c]].AddPlane(normal.x, normal.y, normal.z, d, area);
+	}
+
+	const double maxCost = (double)targetError * (double)targetError;
+	double reachedCost = 0.0;
+
+	std::vector<Collapse> collapses;
+	std::vector<uint> adjacencyOffsets(numVertices + 1);
+	std::vector<uint> adjacency;
+	std::vector<bool> touched(numVertices);
+
+	// Each pass collapses the cheapest independent edges, then the triangle list is compacted
+	while (destination.size() > targetIndexCount)
+	{
+		const uint numTriangles = (uint)destination.size() / 3;
+
+		collapses.clear();
+		for (uint t = 0; t < numTriangles; ++t)
+		{
+			for (int e = 0; e < 3; ++e)
+			{
+				const uint a = destination[t * 3 + e], b = destination[t * 3 + (e + 1) % 3];
+				// A vertex can only land on one that is alone at its position, seams would get the wrong attributes
+				for (int direction = 0; direction < 2; ++direction)
+				{
+					const uint from = direction == 0 ? a : b, to = direction == 0 ? b : a;
+					if (locked[from] || positionCount[firstOfPosition[to]] > 1)
+						continue;
+
+					Quadric quadric = quadrics[from];
+					quadric.Add(quadrics[to]);
+					Collapse collapse;
+					collapse.from = from;
+					collapse.to = to;
+					collapse.cost = (float)quadric.Error(positions[to]);
+					collapses.push_back(collapse);
+				}
+			}
+		}
+		if (collapses.empty())
+			break;
+		std::sort(collapses.begin(), collapses.end());
+
+		// Triangles around each vertex
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint index : destination)
+			++adjacencyOffsets[index + 1];
+		for (uint i = 0; i < numVertices; ++i)
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+		adjacency.resize(destination.size());
+		{
+			std::vector<uint> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (uint i = 0; i < (uint)destination.size(); ++i)
+				adjacency[fill[destination[i]]++] = i / 3;
+		}
+
+		// About two triangles go away per collapse, leave the rest for the next pass so the order stays right
+		const uint trianglesToRemove = numTriangles - targetIndexCount / 3;
+		const uint maxCollapses = trianglesToRemove / 2 + 1;
+		std::fill(touched.begin(), touched.end(), false);
+
+		uint performed = 0;
+		for (const Collapse& collapse : collapses)
+		{
+			if (performed >= maxCollapses || collapse.cost > maxCost)
+				break;
+			if (touched[collapse.from] || touched[collapse.to])
+				continue;
+
+			// Moving the vertex must not flip any of the triangles that survive the collapse
+			bool flips = false;
+			for (uint k = adjacencyOffsets[collapse.from]; k < adjacencyOffsets[collapse.from + 1] && !flips; ++k)
+			{
+				const uint* triangle = &destination[adjacency[k] * 3];
+				if (IsDegenerate(triangle) || triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+					continue;
+
+				float3 corners[3], moved[3];
+				for (int c = 0; c < 3; ++c)
+				{
+					corners[c] = positions[triangle[c]];
+					moved[c] = triangle[c] == collapse.from ? positions[collapse.to] : corners[c];
+				}
+				const float3 before = (corners[1] - corners[0]).Cross(corners[2] - corners[0]);
+				const float3 after = (moved[1] - moved[0]).Cross(moved[2] - moved[0]);
+				flips = before.Dot(after) <= 0.f;
+			}
+			if (flips)
+				continue;
+
+			for (uint k = adjacencyOffsets[collapse.from]; k < adjacencyOffsets[collapse.from + 1]; ++k)
+			{
+				uint* triangle = &destination[adjacency[k] * 3];
+				for (int c = 0; c < 3; ++c)
+				{
+					if (triangle[c] == collapse.from)
+						triangle[c] = collapse.to;
+				}
+			}
+
+			quadrics[collapse.to].Add(quadrics[collapse.from]);
+			touched[collapse.from] = true;
+			touched[collapse.to] = true;
+			reachedCost = collapse.cost > reachedCost ? collapse.cost : reachedCost;
+			++performed;
+		}
+
+		if (performed == 0)
+			break;
+
+		// Drop the triangles the collapses folded away
+		uint write = 0;
+		for (uint t = 0; t < numTriangles; ++t)
+		{
+			const uint* triangle = &destination[t * 3];
+			if (IsDegenerate(triangle))
+				continue;
+			destination[write++] = triangle[0];
+			destination[write++] = triangle[1];
+			destination[write++] = triangle[2];
+		}
+		destination.resize(write);
+	}
+
+	return (float)sqrt(reachedCost);
+}
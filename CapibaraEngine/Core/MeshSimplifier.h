@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Globals.h"
+#include "Math/float3.h"
+#include <vector>
+
+// Quadric error edge collapse. Vertices are never moved or added, a collapse only rewires the
+// triangles of one vertex onto a neighbour, so every level of detail can index the vertex buffer
+// of the full mesh. Open borders and uv / normal seams are kept in place.
+namespace MeshSimplifier
+{
+	// Writes the simplified triangles to destination and returns the error reached, as a fraction of
+	// the mesh extent. Stops at targetIndexCount or when the next collapse would go over targetError.
+	float Simplify(const std::vector<float3>& vertices, const std::vector<uint>& indices, uint targetIndexCount, float targetError, std::vector<uint>& destination);
+}
@@ -5,11 +5,32 @@
 #include "rapidjson-1.1.0/include/rapidjson/prettywriter.h"
 #include "rapidjson-1.1.0/include/rapidjson/document.h"
 
+#include <vector>
+
 class Application;
+class Module;
 
 typedef rapidjson::PrettyWriter<rapidjson::StringBuffer> JSONWriter;
 typedef rapidjson::Value JSONReader;
 
+// Frame phases as bits, to declare which phases a module works in and what it touches in each
+enum FramePhase
+{
+	PHASE_PRE_UPDATE = 1 << 0,
+	PHASE_UPDATE = 1 << 1,
+	PHASE_POST_UPDATE = 1 << 2,
+	PHASE_ALL = PHASE_PRE_UPDATE | PHASE_UPDATE | PHASE_POST_UPDATE
+};
+
+#define FRAME_PHASE_COUNT 3
+
+struct ModuleAccess
+{
+	Module* module;
+	uint phases;
+	bool write;
+};
+
 class Module
 {
 private :
@@ -64,6 +85,23 @@ public:
 	}
 
 	virtual void OnGui() {}
+
+	// Frame scheduling, declared before Init. A module always writes itself. Two modules that touch the
+	// same module in a phase, one of them writing, keep the order they were added in, others may overlap.
+	inline void Reads(Module* module, uint phases = PHASE_ALL) { accesses.push_back({ module, phases, false }); }
+	inline void Writes(Module* module, uint phases = PHASE_ALL) { accesses.push_back({ module, phases, true }); }
+	inline void RunsOn(uint phases) { this->phases = phases; } // The other phases are skipped
+
+	inline void SetName(const char* name) { this->name = name; }
+	inline const char* GetName() const { return name; }
+
+public:
+	uint phases = PHASE_ALL;
+	bool mainThreadOnly = true; // SDL, GL and ImGui are only used from the main thread
+	std::vector<ModuleAccess> accesses;
+
+private:
+	const char* name = "Module";
 };
 
 #endif
\ No newline at end of file
@@ -194,51 +194,36 @@ void ModuleCamera3D::MousePicking()
 // -----------------------------------------------------------------
 void ModuleCamera3D::RayIntersectionTest(LineSegment ray)
 {
-	std::map<float, GameObject*> selectedList;
-	float hit, firstHit;
+	// Candidates come from the scene tree sorted by box entry distance, nested objects included
+	std::vector<AABBTreeRayHit> candidates;
+	App->scene->sceneTree.QueryRay(ray, candidates);
 
-	for (std::vector<GameObject*>::iterator i = App->scene->root->children.begin(); i != App->scene->root->children.end(); ++i)
-	{
-		if ((*i)->name != "Camera")
-			if (ray.Intersects((*i)->globalAABB, hit, firstHit))
-				selectedList[hit] = (*i);
-	}
-	
-	std::map<float, GameObject*> distanceMap;
+	GameObject* closestObject = nullptr;
+	float closestDistance = FLOAT_INF;
 
-	for (auto i = selectedList.begin(); i != selectedList.end(); ++i)
+	for (const AABBTreeRayHit& candidate : candidates)
 	{
-		ComponentMesh* mesh = (*i).second->GetComponent<ComponentMesh>();
-		if (mesh)
-		{
-			ray.Transform((*i).second->transform->transformMatrix.Inverted());
+		// Nothing further away can beat the closest triangle hit
+		if (candidate.distance > closestDistance)
+			break;
 
-			if (mesh->numVertices >= 9)
-			{
-				for (int index = 0; index < mesh->numIndices; index += 3)
-				{
-					Triangle triangle(mesh->vertices[mesh->indices[index]], mesh->vertices[mesh->indices[index + 1]], mesh->vertices[mesh->indices[index + 2]]);
-					float distance = 0;
-					if (ray.Intersects(triangle, &distance, nullptr))
-						distanceMap[distance] = (*i).second;
-				}
-			}
-		}
-	}
-	selectedList.clear();
+		ComponentMesh* mesh = candidate.object->GetComponent<ComponentMesh>();
+		if (mesh == nullptr || mesh->numVertices < 9)
+			continue;
 
-	bool selected = false;
+		LineSegment localRay = ray;
+		localRay.Transform(candidate.object->transform->GetGlobalMatrix().Inverted());
 
-	if (distanceMap.begin() != distanceMap.end())
-	{
-		App->editor->gameobjectSelected = (*distanceMap.begin()).second;
-		selected = true;
+		// Triangle BVH only reports hits closer than the best one so far
+		float distance = 0.f;
+		if (mesh->bvh.RayCast(localRay, mesh->vertices, mesh->indices, closestDistance, distance))
+		{
+			closestDistance = distance;
+			closestObject = candidate.object;
+		}
 	}
-	
-	distanceMap.clear();
 
-	if (!selected)
-		App->editor->gameobjectSelected = nullptr;
+	App->editor->gameobjectSelected = closestObject;
 }
 
 // -----------------------------------------------------------------
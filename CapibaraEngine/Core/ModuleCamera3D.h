@@ -6,6 +6,7 @@
 #include "Geometry/Frustum.h"
 #include "Geometry/LineSegment.h"
 #include "Geometry/Triangle.h"
+#include "RenderView.h"
 #include <map>
 
 class ModuleCamera3D : public Module
@@ -39,6 +40,8 @@ public:
 	float cameraSpeed = 60.f;
 	bool projectionIsDirty = false;
 
+	RenderView view; // Editor viewport
+
 private:
 
 	float lastDeltaX = 0.f, lastDeltaY = 0.f;
@@ -0,0 +1,196 @@
+#include "ModuleDebugDraw.h"
+#include "Application.h"
+#include "ImGui/imgui.h"
+
+// The twelve edges of a box, as pairs of corner indices
+static const int boxEdges[24] =
+{
+	0,2, 2,6, 6,4, 4,0,
+	0,1, 1,3, 3,2, 4,5,
+	6,7, 5,7, 3,7, 1,5,
+};
+
+ModuleDebugDraw::ModuleDebugDraw(Application* app, bool start_enabled) : Module(app, start_enabled)
+{}
+
+ModuleDebugDraw::~ModuleDebugDraw()
+{}
+
+update_status ModuleDebugDraw::PreUpdate(float dt)
+{
+	// Anything queued after the last flush belongs to a view that was already drawn
+	Clear();
+
+	return UPDATE_CONTINUE;
+}
+
+bool ModuleDebugDraw::CleanUp()
+{
+	batches.clear();
+	lineBuffers.clear();
+
+	return true;
+}
+
+void ModuleDebugDraw::OnGui()
+{
+	if (ImGui::CollapsingHeader("Debug Draw"))
+	{
+		ImGui::Checkbox("Enabled", &active);
+		ImGui::Text("%d lines in %d draws", lastLines, lastDraws);
+	}
+}
+
+void ModuleDebugDraw::Line(const float3& from, const float3& to, const Color& color, float width, bool depthTest)
+{
+	std::vector<LineVertex>& vertices = GetBatch(width, depthTest);
+	const uint packed = LineVertex::PackColor(color);
+
+	LineVertex vertex;
+	vertex.color = packed;
+	vertex.position = from;
+	vertices.push_back(vertex);
+	vertex.position = to;
+	vertices.push_back(vertex);
+}
+
+void ModuleDebugDraw::Lines(const float3* points, uint numPoints, const Color& color, float width, bool depthTest)
+{
+	std::vector<LineVertex>& vertices = GetBatch(width, depthTest);
+	const uint packed = LineVertex::PackColor(color);
+
+	LineVertex vertex;
+	vertex.color = packed;
+	for (uint i = 0; i + 1 < numPoints; i += 2)
+	{
+		vertex.position = points[i];
+		vertices.push_back(vertex);
+		vertex.position = points[i + 1];
+		vertices.push_back(vertex);
+	}
+}
+
+void ModuleDebugDraw::Box(const float3* corners, const Color& color, float width, bool depthTest)
+{
+	std::vector<LineVertex>& vertices = GetBatch(width, depthTest);
+	const uint packed = LineVertex::PackColor(color);
+
+	LineVertex vertex;
+	vertex.color = packed;
+	for (int i = 0; i < 24; ++i)
+	{
+		vertex.position = corners[boxEdges[i]];
+		vertices.push_back(vertex);
+	}
+}
+
+void ModuleDebugDraw::Box(const AABB& box, const Color& color, float width, bool depthTest)
+{
+	float3 corners[8];
+	box.GetCornerPoints(corners);
+	Box(corners, color, width, depthTest);
+}
+
+void ModuleDebugDraw::Box(const OBB& box, const Color& color, float width, bool depthTest)
+{
+	float3 corners[8];
+	box.GetCornerPoints(corners);
+	Box(corners, color, width, depthTest);
+}
+
+void ModuleDebugDraw::Frustum(const ::Frustum& frustum, const Color& color, float width, bool depthTest)
+{
+	float3 corners[8];
+	frustum.GetCornerPoints(corners);
+	Box(corners, color, width, depthTest);
+}
+
+void ModuleDebugDraw::Axes(const float3& position, const float3& right, const float3& up, const float3& front, float width, bool depthTest)
+{
+	Line(position, position + right, Color(1.f, 0.f, 0.f), width, depthTest);
+	Line(position, position + up, Color(0.f, 1.f, 0.f), width, depthTest);
+	Line(position, position + front, Color(0.f, 0.f, 1.f), width, depthTest);
+}
+
+void ModuleDebugDraw::LineBuffer(uint vertexBuffer, uint numPoints, const Color& color, const float4x4& transform)
+{
+	if (vertexBuffer == 0 || numPoints < 2)
+		return;
+
+	LineBufferCall call;
+	call.vertexBuffer = vertexBuffer;
+	call.numPoints = numPoints;
+	call.color = color;
+	call.transform = transform;
+	lineBuffers.push_back(call);
+}
+
+void ModuleDebugDraw::Flush(RenderBackend* backend)
+{
+	lastLines = 0;
+	lastDraws = 0;
+
+	if (!active)
+	{
+		Clear();
+		return;
+	}
+
+	const bool lighting = backend->GetState(RenderState::LIGHTING);
+	const bool texture = backend->GetState(RenderState::TEXTURE_2D);
+	const bool depthTest = backend->GetState(RenderState::DEPTH_TEST);
+	backend->SetState(RenderState::LIGHTING, false);
+	backend->SetState(RenderState::TEXTURE_2D, false);
+	backend->SetState(RenderState::DEPTH_TEST, true);
+
+	for (const LineBufferCall& call : lineBuffers)
+	{
+		backend->DrawLineBuffer(call.vertexBuffer, call.numPoints, call.color, call.transform);
+		lastLines += call.numPoints / 2;
+		++lastDraws;
+	}
+
+	// Depth tested groups first so the overlays end up on top of them
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		const bool tested = pass == 0;
+		for (LineBatch& batch : batches)
+		{
+			if (batch.depthTest != tested || batch.vertices.empty())
+				continue;
+
+			backend->SetState(RenderState::DEPTH_TEST, tested);
+			backend->DrawLineList(batch.vertices.data(), (uint)batch.vertices.size(), batch.width);
+			lastLines += (uint)batch.vertices.size() / 2;
+			++lastDraws;
+		}
+	}
+
+	backend->SetState(RenderState::DEPTH_TEST, depthTest);
+	backend->SetState(RenderState::TEXTURE_2D, texture);
+	backend->SetState(RenderState::LIGHTING, lighting);
+
+	Clear();
+}
+
+std::vector<LineVertex>& ModuleDebugDraw::GetBatch(float width, bool depthTest)
+{
+	// Only a handful of widths are ever used, a linear search is enough
+	for (LineBatch& batch : batches)
+	{
+		if (batch.width == width && batch.depthTest == depthTest)
+			return batch.vertices;
+	}
+
+	batches.push_back(LineBatch());
+	batches.back().width = width;
+	batches.back().depthTest = depthTest;
+	return batches.back().vertices;
+}
+
+void ModuleDebugDraw::Clear()
+{
+	for (LineBatch& batch : batches)
+		batch.vertices.clear();
+	lineBuffers.clear();
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "Module.h"
+#include "Globals.h"
+#include "RenderBackend.h"
+#include "Geometry/AABB.h"
+#include "Geometry/OBB.h"
+#include "Geometry/Frustum.h"
+
+#include <vector>
+
+// Collects the debug geometry of a frame (lines, boxes, frustums, axes) and draws it in one go.
+// Lines are grouped by width and depth test, every group is a single streamed draw. Static line
+// buffers, like the grid or the normals of a mesh, are drawn in place with their own transform.
+class ModuleDebugDraw : public Module
+{
+public:
+	ModuleDebugDraw(Application* app, bool start_enabled = true);
+	~ModuleDebugDraw();
+
+	update_status PreUpdate(float dt) override;
+	bool CleanUp() override;
+	void OnGui() override;
+
+	void Line(const float3& from, const float3& to, const Color& color, float width = 1.f, bool depthTest = true);
+	void Lines(const float3* points, uint numPoints, const Color& color, float width = 1.f, bool depthTest = true); // Pairs of points
+	void Box(const float3* corners, const Color& color, float width = 1.f, bool depthTest = true); // Corners in MathGeoLib order
+	void Box(const AABB& box, const Color& color, float width = 1.f, bool depthTest = true);
+	void Box(const OBB& box, const Color& color, float width = 1.f, bool depthTest = true);
+	void Frustum(const ::Frustum& frustum, const Color& color, float width = 1.f, bool depthTest = true);
+	void Axes(const float3& position, const float3& right, const float3& up, const float3& front, float width = 1.f, bool depthTest = true);
+	void LineBuffer(uint vertexBuffer, uint numPoints, const Color& color, const float4x4& transform = float4x4::identity);
+
+	// Draws everything queued so far into the bound target and empties the queue
+	void Flush(RenderBackend* backend);
+
+public:
+	bool active = true;
+
+private:
+	struct LineBatch
+	{
+		float width;
+		bool depthTest;
+		std::vector<LineVertex> vertices;
+	};
+
+	struct LineBufferCall
+	{
+		uint vertexBuffer;
+		uint numPoints;
+		Color color;
+		float4x4 transform;
+	};
+
+	std::vector<LineVertex>& GetBatch(float width, bool depthTest);
+	void Clear();
+
+private:
+	// Batches are kept between frames so their storage is reused
+	std::vector<LineBatch> batches;
+	std::vector<LineBufferCall> lineBuffers;
+
+	uint lastLines = 0;
+	uint lastDraws = 0;
+};
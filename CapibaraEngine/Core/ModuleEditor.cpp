@@ -11,10 +11,13 @@
 #include "ModuleViewportFrameBuffer.h"
 #include "ModuleCamera3D.h"
 #include "ModuleTextures.h"
+#include "ModuleDebugDraw.h"
 #include "ComponentMaterial.h"
 #include "ComponentMesh.h"
 #include "ComponentTransform.h"
 #include "ComponentCamera.h"
+#include "Profiler.h"
+#include "FrameArena.h"
 
 //Tools
 
@@ -23,8 +26,6 @@
 #include "ImGui/imgui_impl_opengl3.h"
 #include "ImGui/imgui_impl_sdl.h"
 #include "ImGui/imgui_internal.h"
-#include "glew.h"
-#include <gl/GL.h>
 
 ModuleEditor::ModuleEditor(Application* app, bool start_enabled) : Module(app, start_enabled)
 {
@@ -41,6 +42,7 @@ ModuleEditor::ModuleEditor(Application* app, bool start_enabled) : Module(app, s
     showSceneWindow = true;
     showTexturesWindow = true;
     showAssetsWindow = true;
+    showProfilerWindow = false;
 
     currentColor = { 1.0f, 1.0f, 1.0f, 1.0f };
     
@@ -79,8 +81,19 @@ bool ModuleEditor::Start()
     ImGui::StyleColorsDark();
 
     // Setup Platform/Renderer bindings
-	ImGui_ImplOpenGL3_Init();
-    ImGui_ImplSDL2_InitForOpenGL(App->window->window, App->renderer3D->context);
+    if (App->headless)
+    {
+        // No platform or renderer backend, ImGui still builds its draw lists every frame
+        unsigned char* pixels = nullptr;
+        int width = 0, height = 0;
+        io.DisplaySize = ImVec2((float)App->window->width, (float)App->window->height);
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    }
+    else
+    {
+        ImGui_ImplOpenGL3_Init();
+        ImGui_ImplSDL2_InitForOpenGL(App->window->window, App->renderer3D->context);
+    }
     
     CreateGridBuffer();
 
@@ -93,8 +106,15 @@ bool ModuleEditor::Start()
 update_status ModuleEditor::PreUpdate(float dt) {
 
     // Start the Dear ImGui frame
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplSDL2_NewFrame(App->window->window);
+    if (App->headless)
+    {
+        ImGui::GetIO().DeltaTime = dt > 0.f ? dt : 1.f / 60.f;
+    }
+    else
+    {
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplSDL2_NewFrame(App->window->window);
+    }
     ImGui::NewFrame();
 
     return UPDATE_CONTINUE;
@@ -104,7 +124,6 @@ update_status ModuleEditor::PreUpdate(float dt) {
 // PreUpdate: clear buffer
 update_status ModuleEditor::Update(float dt)
 {
-    DrawGrid();
     //Creating MenuBar item as a root for docking windows
     if (DockingRootItem("Viewport", ImGuiWindowFlags_MenuBar)) {
         MenuBar();
@@ -113,11 +132,9 @@ update_status ModuleEditor::Update(float dt)
 
     if (gameobjectSelected != nullptr && App->input->GetKey(SDL_SCANCODE_DELETE) == KEY_DOWN)
     {
-        if (gameobjectSelected != App->scene->root)
-        {
-            App->scene->CleanUpSelectedGameObject(gameobjectSelected);
+        // Refused for the object that holds the game camera
+        if (gameobjectSelected != App->scene->root && App->scene->CleanUpSelectedGameObject(gameobjectSelected))
             gameobjectSelected = nullptr;
-        }
     }
 
     //Update status of each window and shows ImGui elements
@@ -132,8 +149,11 @@ update_status ModuleEditor::PostUpdate(float dt) {
 
     // Rendering
     ImGui::Render();
-    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    if (!App->headless)
+    {
+        App->renderer3D->backend->SetViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
 
     // Update and Render additional Platform Windows
         // (Platform functions may change the current OpenGL context, so we save/restore it to make it easier to paste this code elsewhere.
@@ -156,8 +176,13 @@ update_status ModuleEditor::PostUpdate(float dt) {
 bool ModuleEditor::CleanUp()
 {
 
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplSDL2_Shutdown();
+    App->renderer3D->backend->DeleteBuffer(grid.vertexBuffer);
+
+    if (!App->headless)
+    {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplSDL2_Shutdown();
+    }
     ImGui::DestroyContext();
 
 	return true;
@@ -166,7 +191,6 @@ bool ModuleEditor::CleanUp()
 void ModuleEditor::CreateGridBuffer()
 {
     std::vector<float3> vertices;
-    std::vector<uint> indices;
     constexpr int slices = 200;
     constexpr float size = 2000.f;
     constexpr float halfSize = size * .5f;
@@ -179,80 +203,30 @@ void ModuleEditor::CreateGridBuffer()
         {
             vertices.push_back(float3(x, 0.f, -halfSize));
             vertices.push_back(float3(x, 0.f, halfSize));
-            indices.push_back(vertices.size() - 2);
-            indices.push_back(vertices.size() - 1);
         }
         const float z = -halfSize + static_cast<float>(i) * sliceSize;
         if (z > 0.01f || z < -0.01f)
         {
             vertices.push_back(float3(-halfSize, 0.f, z));
             vertices.push_back(float3(halfSize, 0.f, z));
-            indices.push_back(vertices.size() - 2);
-            indices.push_back(vertices.size() - 1);
         }
    }
 
-    glGenVertexArrays(1, &grid.VAO);
-    glBindVertexArray(grid.VAO);
-
-    GLuint vbo;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float3), &vertices[0], GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-
-    GLuint ibo;
-    glGenBuffers(1, &ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint), &indices[0], GL_STATIC_DRAW);
-
-    glBindVertexArray(0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    grid.length = (GLuint)indices.size() * 4;
+    // Plain line list, every pair of points is a line so no index buffer is needed
+    grid.vertexBuffer = App->renderer3D->backend->CreateBuffer(BufferType::VERTEX, &vertices[0], (uint)(vertices.size() * sizeof(float3)));
+    grid.numPoints = (uint)vertices.size();
 }
 
 void ModuleEditor::DrawGrid()
 {
-    GLboolean isLightingOn, isDepthTestOn;
-    glGetBooleanv(GL_LIGHTING, &isLightingOn);
-    glGetBooleanv(GL_DEPTH_TEST, &isDepthTestOn);
-
-    glEnable(GL_DEPTH_TEST);
-    glDisable(GL_LIGHTING);
-    glBindVertexArray(grid.VAO);
-
-    glColor3f(.5f, .5f, .5f);
-    glDrawElements(GL_LINES, grid.length, GL_UNSIGNED_INT, NULL);
-
-    glBindVertexArray(0);
-    
-    glBegin(GL_LINES);
-        //x Axis
-        glColor3f(1.f, 0.f, 0.f);
-        glVertex3f(0.f, 0.0f, 0.f);
-        glColor3f(1.f, 0.f, 0.f);
-        glVertex3f(1000.f, 0.0f, 0.f);
-        glColor3f(.2f, 0.f, 0.f);
-        glVertex3f(0.f, 0.0f, 0.f);
-        glColor3f(.2f, 0.f, 0.f);
-        glVertex3f(-1000.f, 0.0f, 0.f);
-        //z Axis
-        glColor3f(0.f, 0.f, 1.f);
-        glVertex3f(0.f, 0.0f, 0.f);
-        glColor3f(0.f, 0.f, 1.f);
-        glVertex3f(0.f, 0.0f, 1000.f);
-        glColor3f(0.f, 0.f, .2f);
-        glVertex3f(0.f, 0.0f, 0.f);
-        glColor3f(0.f, 0.f, .2f);
-        glVertex3f(0.f, 0.0f, -1000.f);
-    glEnd();
-
-    isLightingOn ? glEnable(GL_LIGHTING) : 0;
-    !isDepthTestOn ? glDisable(GL_DEPTH_TEST) : 0;
-
+    App->debugDraw->LineBuffer(grid.vertexBuffer, grid.numPoints, Color(.5f, .5f, .5f));
+
+    //x Axis
+    App->debugDraw->Line(float3(0.f, 0.f, 0.f), float3(1000.f, 0.f, 0.f), Color(1.f, 0.f, 0.f));
+    App->debugDraw->Line(float3(0.f, 0.f, 0.f), float3(-1000.f, 0.f, 0.f), Color(.2f, 0.f, 0.f));
+    //z Axis
+    App->debugDraw->Line(float3(0.f, 0.f, 0.f), float3(0.f, 0.f, 1000.f), Color(0.f, 0.f, 1.f));
+    App->debugDraw->Line(float3(0.f, 0.f, 0.f), float3(0.f, 0.f, -1000.f), Color(0.f, 0.f, .2f));
 }
 
 void ModuleEditor::About_Window() {
@@ -299,6 +273,103 @@ void ModuleEditor::About_Window() {
 
 }
 
+void ModuleEditor::ProfilerWindow() {
+
+    ImGui::Begin("Profiler", &showProfilerWindow);
+
+    Profiler& profiler = Profiler::Get();
+    bool recording = Profiler::IsRecording();
+    if (ImGui::Checkbox("Record", &recording))
+        profiler.SetRecording(recording);
+    ImGui::SameLine();
+    ImGui::Checkbox("Pause", &profiler.paused);
+    ImGui::SameLine();
+    if (!profiler.IsCapturing())
+    {
+        if (ImGui::Button("Start Capture"))
+            profiler.StartCapture();
+    }
+    else
+    {
+        if (ImGui::Button("Stop and Export"))
+        {
+            profiler.StopCapture();
+            profiler.ExportChromeTrace(PROFILER_TRACE_FILE);
+        }
+        ImGui::SameLine();
+        ImGui::Text("%d frames", profiler.GetCaptureFrameCount());
+    }
+
+    const std::vector<ProfileEvent>& events = profiler.GetLastFrame();
+    const uint64 frameStart = profiler.GetLastFrameStart();
+    const uint64 frameEnd = profiler.GetLastFrameEnd();
+    if (events.empty() || frameEnd <= frameStart)
+    {
+        ImGui::TextDisabled(recording ? "Waiting for a frame" : "Not recording");
+        ImGui::End();
+        return;
+    }
+
+    const double frameTicks = double(frameEnd - frameStart);
+    ImGui::Text("Frame: %.3f ms, %d zones", Profiler::TicksToMs(frameEnd - frameStart), (uint)events.size());
+    ImGui::Separator();
+
+    // Events come sorted by thread, every thread gets a lane as deep as its deepest zone
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    const float width = ImGui::GetContentRegionAvail().x;
+    const float rowHeight = ImGui::GetTextLineHeight() + 4.f;
+    const ImVec2 mouse = ImGui::GetIO().MousePos;
+    float laneY = origin.y;
+
+    uint first = 0;
+    while (first < events.size())
+    {
+        const uint thread = events[first].thread;
+        uint last = first;
+        uint maxDepth = 0;
+        while (last < events.size() && events[last].thread == thread)
+        {
+            maxDepth = events[last].depth > maxDepth ? events[last].depth : maxDepth;
+            ++last;
+        }
+
+        drawList->AddText(ImVec2(origin.x, laneY), IM_COL32(255, 255, 0, 255), profiler.GetThreadName(thread).c_str());
+        laneY += rowHeight;
+
+        for (uint i = first; i < last; ++i)
+        {
+            const ProfileEvent& event = events[i];
+            const uint64 start = event.start > frameStart ? event.start : frameStart;
+            const uint64 end = event.end < frameEnd ? event.end : frameEnd;
+            if (end <= start)
+                continue;
+
+            const ImVec2 min(origin.x + float(double(start - frameStart) / frameTicks) * width, laneY + event.depth * rowHeight);
+            const ImVec2 max(origin.x + float(double(end - frameStart) / frameTicks) * width, min.y + rowHeight - 1.f);
+
+            // Same name, same color, so a zone is easy to follow from frame to frame
+            const uint hash = (uint)(size_t)event.name * 2654435761u;
+            drawList->AddRectFilled(min, max, IM_COL32(80 + (hash >> 24) % 120, 80 + (hash >> 16) % 120, 80 + (hash >> 8) % 120, 255));
+            if (max.x - min.x > 20.f)
+            {
+                drawList->PushClipRect(min, max, true);
+                drawList->AddText(ImVec2(min.x + 2.f, min.y + 2.f), IM_COL32(255, 255, 255, 255), event.name);
+                drawList->PopClipRect();
+            }
+
+            if (mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y && ImGui::IsWindowHovered())
+                ImGui::SetTooltip("%s: %.3f ms", event.name, Profiler::TicksToMs(event.end - event.start));
+        }
+
+        laneY += (maxDepth + 1) * rowHeight + 4.f;
+        first = last;
+    }
+    ImGui::Dummy(ImVec2(width, laneY - origin.y));
+
+    ImGui::End();
+}
+
 void ModuleEditor::UpdateText(const char* text)
 {
     consoleText.appendf(text);
@@ -435,6 +506,8 @@ void ModuleEditor::MenuBar()
                 showTexturesWindow = !showTexturesWindow;
             if (ImGui::MenuItem("Assets"))
                 showAssetsWindow = !showAssetsWindow;
+            if (ImGui::MenuItem("Profiler"))
+                showProfilerWindow = !showProfilerWindow;
 
             ImGui::Separator();
             if (ImGui::MenuItem("Configuration")) 
@@ -477,6 +550,9 @@ void ModuleEditor::UpdateWindowStatus()
     if (showAboutWindow)
         About_Window();
 
+    if (showProfilerWindow)
+        ProfilerWindow();
+
     //Config
     if (showConfWindow)
     {
@@ -572,11 +648,8 @@ void ModuleEditor::UpdateWindowStatus()
 
             if (ImGui::Button("Clear", { 100,20 }))
             {
-                if (gameobjectSelected->name != "Camera")
-                {
-                    App->scene->CleanUpSelectedGameObject(gameobjectSelected); //Clean GameObjects
+                if (App->scene->CleanUpSelectedGameObject(gameobjectSelected)) //Clean GameObjects
                     gameobjectSelected = nullptr;
-                }
             }
             ImGui::SameLine();
 
@@ -593,8 +666,8 @@ void ModuleEditor::UpdateWindowStatus()
                 App->scene->CreateRoot();
         }
 
-        std::stack<GameObject*> S;
-        std::stack<uint> indents;
+        FrameStack<GameObject*> S;
+        FrameStack<uint> indents;
         S.push(App->scene->root);
         indents.push(0);
         while (!S.empty())
@@ -682,7 +755,7 @@ void ModuleEditor::UpdateWindowStatus()
             }
 
             lastViewportGameSize = viewportSize;
-            ImGui::Image((ImTextureID)App->viewportBufferGame->texture, viewportSize, ImVec2(0, 1), ImVec2(1, 0));
+            ImGui::Image((ImTextureID)App->viewportBufferGame->target.texture, viewportSize, ImVec2(0, 1), ImVec2(1, 0));
         }
 
         ImGui::End();
@@ -700,7 +773,7 @@ void ModuleEditor::UpdateWindowStatus()
             App->camera->RecalculateProjection();
         }
         lastViewportSize = viewportSize;
-        ImGui::Image((ImTextureID)App->viewportBuffer->texture, viewportSize, ImVec2(0, 1), ImVec2(1, 0));
+        ImGui::Image((ImTextureID)App->viewportBuffer->target.texture, viewportSize, ImVec2(0, 1), ImVec2(1, 0));
         
         if (App->input->GetMouseButton(SDL_BUTTON_LEFT) == KEY_DOWN)
             App->camera->MousePicking();
@@ -715,8 +788,3 @@ void ModuleEditor::InspectorGameObject()
     if (gameobjectSelected)
         gameobjectSelected->OnGui();
 }
-
-ModuleEditor::Grid::~Grid()
-{
-    glDeleteBuffers(1, &VAO);
-}
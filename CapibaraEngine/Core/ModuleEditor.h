@@ -16,10 +16,8 @@ class ModuleEditor : public Module
 
 	struct Grid
 	{
-		uint VAO;
-		uint length;
-
-		~Grid();
+		uint vertexBuffer = 0;
+		uint numPoints = 0;
 	};
 
 	Grid grid;
@@ -50,6 +48,7 @@ public:
 	void UpdateText(const char* consoleText);
 
 	void About_Window();	//Can be done better
+	void ProfilerWindow();	//Flame graph of the last frame, one lane per thread
 	void InspectorGameObject();
 
 	//Window status control
@@ -64,6 +63,7 @@ public:
 	bool showTexturesWindow;
 	bool showConsoleWindow;
 	bool showAssetsWindow;
+	bool showProfilerWindow;
 
 	ImGuiTextBuffer consoleText;
 
@@ -6,6 +6,7 @@
 #include "PhysFS/include/physfs.h"
 #include <fstream>
 #include <filesystem>
+#include <sys/stat.h>
 
 #include "Assimp/include/cfileio.h"
 #include "Assimp/include/types.h"
@@ -398,6 +399,65 @@ uint ModuleFileSystem::Load(const char* file, char** buffer) const
 	return ret;
 }
 
+FileView ModuleFileSystem::Map(const char* file) const
+{
+	FileView view;
+
+	// Files that live in a mounted directory can be mapped straight from disk
+	const char* realDir = PHYSFS_getRealDir(file);
+	std::string realPath;
+	if (realDir != nullptr)
+	{
+		DWORD attributes = GetFileAttributesA(realDir);
+		if (attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY))
+			realPath = std::string(realDir) + "/" + file;
+	}
+	else if (GetFileAttributesA(file) != INVALID_FILE_ATTRIBUTES)
+	{
+		realPath = file; //outside the filesystem
+	}
+
+	if (!realPath.empty())
+	{
+		HANDLE fileHandle = CreateFileA(realPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (fileHandle != INVALID_HANDLE_VALUE)
+		{
+			LARGE_INTEGER fileSize;
+			if (GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0)
+			{
+				HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+				if (mappingHandle != NULL)
+				{
+					const void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+					if (data != nullptr)
+					{
+						view.data = (const char*)data;
+						view.size = (uint64)fileSize.QuadPart;
+						view.fileHandle = fileHandle;
+						view.mappingHandle = mappingHandle;
+						return view;
+					}
+					CloseHandle(mappingHandle);
+				}
+			}
+			CloseHandle(fileHandle);
+		}
+		LOG("File System could not map %s, using a buffered read", realPath.c_str());
+	}
+
+	// Archives (or mapping failure): buffered read owned by the view
+	char* buffer = nullptr;
+	uint size = Load(file, &buffer);
+	if (buffer != nullptr)
+	{
+		view.ownedBuffer = buffer;
+		view.data = buffer;
+		view.size = size;
+	}
+
+	return view;
+}
+
 bool ModuleFileSystem::DuplicateFile(const char* file, const char* dstFolder, std::string& relativePath)
 {
 	std::string fileStr, extensionStr;
@@ -502,12 +562,26 @@ bool ModuleFileSystem::Remove(const char * file)
 	return ret;
 }
 */
-/*
-uint64 ModuleFileSystem::GetLastModTime(const char* filename)
+bool ModuleFileSystem::GetFileStats(const char* file, uint64& modTime, uint64& size) const
 {
-	return PHYSFS_getLastModTime(filename);
+	PHYSFS_Stat stat;
+	if (PHYSFS_stat(file, &stat) != 0 && stat.filetype == PHYSFS_FILETYPE_REGULAR)
+	{
+		modTime = (uint64)stat.modtime;
+		size = (uint64)stat.filesize;
+		return true;
+	}
+
+	//possibly it's from outside the filesystem -> stat as C
+	struct _stat64 cStat;
+	if (_stat64(file, &cStat) == 0)
+	{
+		modTime = (uint64)cStat.st_mtime;
+		size = (uint64)cStat.st_size;
+		return true;
+	}
+	return false;
 }
-*/
 std::string ModuleFileSystem::GetUniqueName(const char* path, const char* name) const
 {
 	//TODO: modify to distinguix files and dirs?
@@ -562,4 +636,51 @@ std::string ModuleFileSystem::SetNormalName(const char* path) {
 		new_name = name.substr(name.find_last_of('/') + 1);
 	}
 	return new_name;
-}
\ No newline at end of file
+}
+
+// FileView ---------------------------------------------
+FileView::~FileView()
+{
+	Release();
+}
+
+FileView::FileView(FileView&& other)
+{
+	*this = std::move(other);
+}
+
+FileView& FileView::operator=(FileView&& other)
+{
+	if (this != &other)
+	{
+		Release();
+		data = other.data;
+		size = other.size;
+		fileHandle = other.fileHandle;
+		mappingHandle = other.mappingHandle;
+		ownedBuffer = other.ownedBuffer;
+
+		other.data = nullptr;
+		other.size = 0;
+		other.fileHandle = nullptr;
+		other.mappingHandle = nullptr;
+		other.ownedBuffer = nullptr;
+	}
+	return *this;
+}
+
+void FileView::Release()
+{
+	if (mappingHandle != nullptr)
+	{
+		UnmapViewOfFile(data);
+		CloseHandle((HANDLE)mappingHandle);
+		CloseHandle((HANDLE)fileHandle);
+	}
+	RELEASE_ARRAY(ownedBuffer);
+
+	data = nullptr;
+	size = 0;
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+}
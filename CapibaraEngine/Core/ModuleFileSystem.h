@@ -14,6 +14,38 @@ struct aiFileIO;
 class Config;
 struct PathNode;
 
+// Read-only view of a whole file. Files on disk are memory mapped, entries inside archives are read into an owned buffer.
+// The view is released when it goes out of scope.
+class FileView
+{
+public:
+	FileView() {}
+	~FileView();
+
+	FileView(FileView&& other);
+	FileView& operator=(FileView&& other);
+
+	FileView(const FileView&) = delete;
+	FileView& operator=(const FileView&) = delete;
+
+	inline const char* Data() const { return data; }
+	inline uint64 Size() const { return size; }
+	inline bool IsValid() const { return data != nullptr; }
+	inline bool IsMapped() const { return mappingHandle != nullptr; }
+
+	void Release();
+
+private:
+	friend class ModuleFileSystem;
+
+	const char* data = nullptr;
+	uint64 size = 0;
+
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+	char* ownedBuffer = nullptr;
+};
+
 class ModuleFileSystem : public Module
 {
 public:
@@ -45,6 +77,7 @@ public:
 	bool Read(const std::string& path, void* data, unsigned size) const; //reads from path and allocates in data. NOTE: The caller should be responsible to clean it
 	bool Exists(const std::string& path) const;
 	unsigned Size(const std::string& path) const;
+	bool GetFileStats(const char* file, uint64& modTime, uint64& size) const; //modTime in seconds since epoch, works outside the filesystem too
 
 	bool HasExtension(const char* path) const;
 	bool HasExtension(const char* path, std::string extension) const;
@@ -56,6 +89,7 @@ public:
 	// Open for Read/Write
 	unsigned int Load(const char* path, const char* file, char** buffer) const;
 	unsigned int Load(const char* file, char** buffer) const;
+	FileView Map(const char* file) const; //zero-copy read access, falls back to a buffered read for archives
 
 	bool DuplicateFile(const char* file, const char* dstFolder, std::string& relativePath);
 	bool DuplicateFile(const char* srcFile, const char* dstFile);
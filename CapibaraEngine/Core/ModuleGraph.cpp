@@ -0,0 +1,213 @@
+#include "ModuleGraph.h"
+#include "JobSystem.h"
+#include "PerfTimer.h"
+#include "Profiler.h"
+#include "ImGui/imgui.h"
+
+#include <thread>
+
+void ModuleGraph::Build(const std::vector<Module*>& modules)
+{
+	this->modules = modules;
+	const uint count = (uint)modules.size();
+
+	timings.assign(count * FRAME_PHASE_COUNT, 0.0);
+	ranOnWorker.assign(count * FRAME_PHASE_COUNT, 0);
+	pending.reset(new std::atomic<uint>[count]);
+	mainReady.reserve(count);
+
+	// Only pairs that conflict get an edge, from the one added first to the other
+	edgeCount = 0;
+	for (uint p = 0; p < FRAME_PHASE_COUNT; ++p)
+	{
+		const uint phaseBit = 1u << p;
+		Phase& phase = phases[p];
+		phase.nodes.clear();
+		phase.successors.assign(count, std::vector<uint>());
+		phase.numPredecessors.assign(count, 0);
+
+		for (uint i = 0; i < count; ++i)
+		{
+			if (modules[i]->phases & phaseBit)
+				phase.nodes.push_back(i);
+		}
+
+		for (uint a = 0; a < phase.nodes.size(); ++a)
+		{
+			for (uint b = a + 1; b < phase.nodes.size(); ++b)
+			{
+				if (Conflicts(phase.nodes[a], phase.nodes[b], phaseBit))
+				{
+					phase.successors[phase.nodes[a]].push_back(phase.nodes[b]);
+					++phase.numPredecessors[phase.nodes[b]];
+					++edgeCount;
+				}
+			}
+		}
+	}
+}
+
+update_status ModuleGraph::Run(FramePhase phase, float dt, JobSystem& jobs)
+{
+	const Phase& graph = phases[PhaseIndex(phase)];
+	if (graph.nodes.empty())
+		return UPDATE_CONTINUE;
+
+	currentPhase = phase;
+	currentDt = dt;
+	this->jobs = &jobs;
+	status = UPDATE_CONTINUE;
+	remaining = (uint)graph.nodes.size();
+	for (uint node : graph.nodes)
+		pending[node] = graph.numPredecessors[node];
+
+	for (uint node : graph.nodes)
+	{
+		if (graph.numPredecessors[node] == 0)
+			Launch(node);
+	}
+
+	// Main thread modules run here, in the order they were added, workers' jobs fill the gaps
+	while (remaining.load() > 0)
+	{
+		int next = -1;
+		{
+			std::lock_guard<std::mutex> lock(mainMutex);
+			for (uint i = 0; i < mainReady.size(); ++i)
+			{
+				if (next < 0 || mainReady[i] < mainReady[next])
+					next = (int)i;
+			}
+			if (next >= 0)
+			{
+				const uint node = mainReady[next];
+				mainReady.erase(mainReady.begin() + next);
+				next = (int)node;
+			}
+		}
+
+		if (next >= 0)
+			RunNode((uint)next);
+		else if (!jobs.RunOne())
+			std::this_thread::yield();
+	}
+
+	return (update_status)status.load();
+}
+
+void ModuleGraph::DrawTimings() const
+{
+	static const char* phaseNames[FRAME_PHASE_COUNT] = { "Pre", "Update", "Post" };
+
+	ImGui::Text("Dependencies: %d", edgeCount);
+	ImGui::Columns(FRAME_PHASE_COUNT + 1, "moduleTimings");
+	ImGui::TextUnformatted("Module");
+	for (uint p = 0; p < FRAME_PHASE_COUNT; ++p)
+	{
+		ImGui::NextColumn();
+		ImGui::TextUnformatted(phaseNames[p]);
+	}
+	ImGui::Separator();
+
+	for (uint i = 0; i < modules.size(); ++i)
+	{
+		ImGui::NextColumn();
+		ImGui::TextUnformatted(modules[i]->GetName());
+		for (uint p = 0; p < FRAME_PHASE_COUNT; ++p)
+		{
+			ImGui::NextColumn();
+			if (modules[i]->phases & (1u << p))
+			{
+				const uint slot = i * FRAME_PHASE_COUNT + p;
+				ImGui::Text("%.3f ms%s", timings[slot], ranOnWorker[slot] ? " (worker)" : "");
+			}
+			else
+			{
+				ImGui::TextDisabled("-");
+			}
+		}
+	}
+	ImGui::Columns(1);
+}
+
+bool ModuleGraph::Conflicts(uint a, uint b, uint phaseBit) const
+{
+	// Every access of one against every access of the other, each module writing itself first
+	const Module* moduleA = modules[a];
+	const Module* moduleB = modules[b];
+	const uint numA = (uint)moduleA->accesses.size() + 1;
+	const uint numB = (uint)moduleB->accesses.size() + 1;
+
+	for (uint i = 0; i < numA; ++i)
+	{
+		const ModuleAccess accessA = i == 0 ? ModuleAccess{ modules[a], PHASE_ALL, true } : moduleA->accesses[i - 1];
+		if ((accessA.phases & phaseBit) == 0)
+			continue;
+
+		for (uint j = 0; j < numB; ++j)
+		{
+			const ModuleAccess accessB = j == 0 ? ModuleAccess{ modules[b], PHASE_ALL, true } : moduleB->accesses[j - 1];
+			if ((accessB.phases & phaseBit) != 0 && accessA.module == accessB.module && (accessA.write || accessB.write))
+				return true;
+		}
+	}
+	return false;
+}
+
+void ModuleGraph::Launch(uint node)
+{
+	// Single thread mode sends everything here, so modules run in the order they were added
+	if (modules[node]->mainThreadOnly || jobs->IsSingleThreaded())
+	{
+		std::lock_guard<std::mutex> lock(mainMutex);
+		mainReady.push_back(node);
+	}
+	else
+	{
+		jobs->Run([this, node]() { RunNode(node); });
+	}
+}
+
+void ModuleGraph::RunNode(uint node)
+{
+	const uint slot = node * FRAME_PHASE_COUNT + PhaseIndex(currentPhase);
+	if (status.load() == UPDATE_CONTINUE)
+	{
+		PROFILE_ZONE(modules[node]->GetName());
+		PerfTimer timer;
+		const update_status ret = CallPhase(modules[node]);
+		timings[slot] = timer.ReadMs();
+
+		int expected = UPDATE_CONTINUE;
+		if (ret != UPDATE_CONTINUE)
+			status.compare_exchange_strong(expected, ret);
+	}
+	else
+	{
+		timings[slot] = 0.0;
+	}
+	ranOnWorker[slot] = !modules[node]->mainThreadOnly && !jobs->IsSingleThreaded();
+
+	for (uint successor : phases[PhaseIndex(currentPhase)].successors[node])
+	{
+		if (--pending[successor] == 0)
+			Launch(successor);
+	}
+	--remaining;
+}
+
+update_status ModuleGraph::CallPhase(Module* module) const
+{
+	switch (currentPhase)
+	{
+	case PHASE_PRE_UPDATE: return module->PreUpdate(currentDt);
+	case PHASE_UPDATE: return module->Update(currentDt);
+	case PHASE_POST_UPDATE: return module->PostUpdate(currentDt);
+	default: return UPDATE_CONTINUE;
+	}
+}
+
+uint ModuleGraph::PhaseIndex(FramePhase phase)
+{
+	return phase == PHASE_PRE_UPDATE ? 0 : phase == PHASE_UPDATE ? 1 : 2;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Globals.h"
+#include "Module.h"
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+
+class JobSystem;
+
+// Per phase dependency graph of the modules, built once from what each module declares it touches.
+// Modules with nothing in common run a phase at the same time, on the workers unless they need the
+// main thread. The main thread always takes the ready module that was added first, so a frame runs
+// the same way every time when only the main thread has work.
+class ModuleGraph
+{
+public:
+	void Build(const std::vector<Module*>& modules);
+
+	// Runs the phase on every module that works in it and returns once all of them are done. After a
+	// module stops or fails, the ones not started yet are skipped, as the old sequential loop did.
+	update_status Run(FramePhase phase, float dt, JobSystem& jobs);
+
+	void DrawTimings() const; // Columns of the last frame, for the Configuration window
+
+	inline uint GetEdgeCount() const { return edgeCount; }
+
+private:
+	struct Phase
+	{
+		std::vector<uint> nodes; // Module indices, in the order they were added
+		std::vector<std::vector<uint>> successors; // Per module index
+		std::vector<uint> numPredecessors;
+	};
+
+	bool Conflicts(uint a, uint b, uint phaseBit) const;
+	void Launch(uint node);
+	void RunNode(uint node);
+	update_status CallPhase(Module* module) const;
+
+	static uint PhaseIndex(FramePhase phase);
+
+private:
+	std::vector<Module*> modules;
+	Phase phases[FRAME_PHASE_COUNT];
+	uint edgeCount = 0;
+
+	// Timings of the last frame, milliseconds per module and phase
+	std::vector<double> timings;
+	std::vector<char> ranOnWorker; // Not bool, modules set theirs from different threads
+
+	// State of the phase being run
+	FramePhase currentPhase = PHASE_PRE_UPDATE;
+	float currentDt = 0.f;
+	JobSystem* jobs = nullptr;
+	std::unique_ptr<std::atomic<uint>[]> pending;
+	std::atomic<uint> remaining;
+	std::atomic<int> status;
+	std::mutex mainMutex;
+	std::vector<uint> mainReady;
+};
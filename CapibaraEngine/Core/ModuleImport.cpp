@@ -2,10 +2,13 @@
 
 #include "Application.h"
 #include "ModuleImport.h"
+#include "VertexEncoding.h"
 #include "ModuleWindow.h"
 #include "ModuleTextures.h"
 #include "ModuleFileSystem.h"
 #include "ModuleScene.h"
+#include "ModuleJobSystem.h"
+#include "Profiler.h"
 #include "ComponentMaterial.h"
 #include "ComponentTransform.h"
 #include "ComponentMesh.h"
@@ -50,9 +53,23 @@ update_status ModuleImport::Update(float dt) {
 
 bool ModuleImport::LoadGeometry(const char* path) {
 
-	//-- Own structure	
-	GameObject* root = nullptr;
-	std::string new_root_name(path);
+	PROFILE_FUNCTION();
+
+	//-- Resolve where the source model lives
+	std::string sourcePath(path);
+	if (!App->fileSystem->Exists(path)) {
+		std::string normPathShort = "Assets/Models/" + App->fileSystem->SetNormalName(path);
+		if (App->fileSystem->Exists(normPathShort))
+			sourcePath = normPathShort;
+	}
+
+	//-- Binary cache, skips Assimp when the source model did not change
+	uint64 sourceModTime = 0, sourceSize = 0;
+	App->fileSystem->GetFileStats(sourcePath.c_str(), sourceModTime, sourceSize);
+	const std::string cachePath = MeshImporter::GetCachePath(sourcePath.c_str());
+
+	if (LoadMeshCache(cachePath, sourceModTime, sourceSize))
+		return true;
 
 	//-- Assimp stuff
 	aiMesh* assimpMesh = nullptr;
@@ -60,32 +77,33 @@ bool ModuleImport::LoadGeometry(const char* path) {
 	aiMaterial* texture = nullptr;
 	aiString texturePath;
 
-	//Create path buffer and import to scene
-	char* buffer = nullptr;
-	uint bytesFile = App->fileSystem->Load(path, &buffer);
+	//Map the model file and import to scene
+	FileView file = App->fileSystem->Map(sourcePath.c_str());
 
-	if (buffer == nullptr) {
-		std::string normPathShort = "Assets/Models/" + App->fileSystem->SetNormalName(path);
-		bytesFile = App->fileSystem->Load(normPathShort.c_str(), &buffer);
-	}
-	if (buffer != nullptr) {
-		scene = aiImportFileFromMemory(buffer, bytesFile, aiProcessPreset_TargetRealtime_MaxQuality, NULL);
-	}
-	else {
-		scene = aiImportFile(path, aiProcessPreset_TargetRealtime_MaxQuality);
+	{
+		PROFILE_ZONE("Assimp Import");
+		if (file.IsValid()) {
+			scene = aiImportFileFromMemory(file.Data(), (uint)file.Size(), aiProcessPreset_TargetRealtime_MaxQuality, NULL);
+		}
+		else {
+			scene = aiImportFile(sourcePath.c_str(), aiProcessPreset_TargetRealtime_MaxQuality);
+		}
 	}
 
 
 	if (scene != nullptr && scene->HasMeshes()) {
+		std::vector<ComponentMesh*> meshes;
+
 		//Use scene->mNumMeshes to iterate on scene->mMeshes array
+		//Scene graph and textures are touched serially, mesh data is copied later on the workers
 		for (size_t i = 0; i < scene->mNumMeshes; i++)
 		{		
-			bool nameFound = false;
 			std::string name;
 			FindNodeName(scene, i, name);
 
 			GameObject* newGameObject = App->scene->CreateGameObject(name);
 			ComponentMesh* mesh = newGameObject->CreateComponent<ComponentMesh>();
+			mesh->geometryKey = MeshImporter::GetGeometryKey(cachePath, (uint)i, sourceModTime);
 			assimpMesh = scene->mMeshes[i];
 			
 			if (scene->HasMaterials()) {
@@ -95,91 +113,211 @@ bool ModuleImport::LoadGeometry(const char* path) {
 					texture->GetTexture(aiTextureType_DIFFUSE, 0, &texturePath);
 					std::string new_path(texturePath.C_Str());
 
-
 					if (new_path.size() > 0) {
 						mesh->texturePath = "Assets/Textures/" + App->fileSystem->SetNormalName(new_path.c_str());
-						if (!App->textures->Find(mesh->texturePath))
-						{
-							const TextureObject& textureObject = App->textures->Load(mesh->texturePath);							
-							ComponentMaterial* materialComp = newGameObject->CreateComponent<ComponentMaterial>();
-							materialComp->SetTexture(textureObject);
-							
-						}
-						else
-						{
-							const TextureObject& textureObject = App->textures->Get(mesh->texturePath);
-							ComponentMaterial* materialComp = newGameObject->CreateComponent<ComponentMaterial>();
-							materialComp->SetTexture(textureObject);
-						}
+						LoadMaterial(newGameObject, mesh);
 					}
 				}
 			}
-	
-			mesh->numVertices = assimpMesh->mNumVertices;
-			mesh->vertices.resize(assimpMesh->mNumVertices);
-			
-			memcpy(&mesh->vertices[0], assimpMesh->mVertices, sizeof(float3) * assimpMesh->mNumVertices);
-			LOG("New mesh with %d vertices", assimpMesh->mNumVertices);
 
-			// -- Copying faces --//
-			if (assimpMesh->HasFaces()) {
-				mesh->numIndices = assimpMesh->mNumFaces * 3;
-				mesh->indices.resize(mesh->numIndices);
+			SetImportRotation(newGameObject);
+			meshes.push_back(mesh);
+		}
 
-				for (size_t i = 0; i < assimpMesh->mNumFaces; i++)
-				{
-					if (assimpMesh->mFaces[i].mNumIndices != 3) {
-						LOG("WARNING, geometry face with != 3 indices!")
-					}
-					else {
-						memcpy(&mesh->indices[i * 3], assimpMesh->mFaces[i].mIndices, 3 * sizeof(uint));
-					}
-				}
-			}
-			
-			// -- Copying Normals info --//
-			if (assimpMesh->HasNormals()) {
+		App->jobSystem->jobs.ParallelFor((uint)meshes.size(), [&](uint i)
+		{
+			MeshImporter::Import(scene->mMeshes[i], meshes[i]);
+		});
+		ProcessMeshes(meshes);
 
-				mesh->normals.resize(assimpMesh->mNumVertices);
-				memcpy(&mesh->normals[0], assimpMesh->mNormals, sizeof(float3) * assimpMesh->mNumVertices);
-			}
-			
-			// -- Copying UV info --//
-			if (assimpMesh->HasTextureCoords(0))
-			{
-				mesh->texCoords.resize(assimpMesh->mNumVertices);
-				for (size_t j = 0; j < assimpMesh->mNumVertices; ++j)
-				{
-					memcpy(&mesh->texCoords[j], &assimpMesh->mTextureCoords[0][j], sizeof(float2));
-				}
-			}
-			
-			float3 newRotationEuler;
-			
-			newRotationEuler.x = -90.f;
+		aiReleaseImport(scene);		
+
+		SaveMeshCache(cachePath, meshes, sourceModTime, sourceSize);
+	}
+	else 
+		LOG("Error loading scene %s", path);
+
+	return true;
+}
+
+bool ModuleImport::LoadMeshCache(const std::string& cachePath, uint64 sourceModTime, uint64 sourceSize)
+{
+	PROFILE_FUNCTION();
+	if (!App->fileSystem->Exists(cachePath))
+		return false;
+
+	FileView file = App->fileSystem->Map(cachePath.c_str());
+	if (!file.IsValid())
+		return false;
 
-			newRotationEuler.x = DEGTORAD * newRotationEuler.x;
-			newRotationEuler.y = DEGTORAD * newRotationEuler.y;
-			newRotationEuler.z = DEGTORAD * newRotationEuler.z;
+	Timer importTimer; importTimer.Start();
 
-			newGameObject->transform->SetRotation(newRotationEuler);
+	MeshCacheHeader header;
+	if (file.Size() < sizeof(header))
+		return false;
+	memcpy(&header, file.Data(), sizeof(header));
 
-			mesh->GenerateBuffers();
-			mesh->GenerateBounds();
-			mesh->ComputeNormals();
+	if (memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != MESH_CACHE_VERSION)
+	{
+		LOG("Mesh cache %s is outdated, reimporting", cachePath.c_str());
+		return false;
+	}
+	if (header.sourceModTime != sourceModTime || header.sourceSize != sourceSize)
+	{
+		LOG("Source model of %s changed, reimporting", cachePath.c_str());
+		return false;
+	}
+
+	// Every block is checked before the scene is touched, a broken cache leaves no half-built model behind
+	const char* const firstBlock = file.Data() + sizeof(header);
+	const char* cursor = firstBlock;
+	uint64 remaining = file.Size() - sizeof(header);
+	for (uint i = 0; i < header.numMeshes; ++i)
+	{
+		uint nameLength = 0;
+		uint64 bytes = 0;
+		if (remaining >= sizeof(nameLength))
+		{
+			memcpy(&nameLength, cursor, sizeof(nameLength));
+			if (remaining - sizeof(nameLength) >= nameLength)
+				bytes = MeshImporter::GetBlockSize(cursor + sizeof(nameLength) + nameLength, remaining - sizeof(nameLength) - nameLength);
 		}
-		aiReleaseImport(scene);		
-		RELEASE_ARRAY(buffer);
+		if (bytes == 0)
+		{
+			LOG("Mesh cache %s is corrupted, mesh %d could not be read, reimporting", cachePath.c_str(), i);
+			return false;
+		}
+		bytes += sizeof(nameLength) + nameLength;
+		cursor += bytes;
+		remaining -= bytes;
+	}
+
+	// Mesh data is copied straight from the mapped file into the components
+	cursor = firstBlock;
+	remaining = file.Size() - sizeof(header);
+	std::vector<ComponentMesh*> meshes;
 
+	for (uint i = 0; i < header.numMeshes; ++i)
+	{
+		// Game object name
+		uint nameLength = 0;
+		memcpy(&nameLength, cursor, sizeof(nameLength));
+		cursor += sizeof(nameLength);
+		remaining -= sizeof(nameLength);
+		std::string name(cursor, nameLength);
+		cursor += nameLength;
+		remaining -= nameLength;
+
+		GameObject* newGameObject = App->scene->CreateGameObject(name);
+		ComponentMesh* mesh = newGameObject->CreateComponent<ComponentMesh>();
+		mesh->geometryKey = MeshImporter::GetGeometryKey(cachePath, i, sourceModTime);
+
+		meshes.push_back(mesh);
+
+		const uint64 bytes = MeshImporter::Load(cursor, remaining, mesh);
+		if (bytes == 0)
+		{
+			// Only the contents are wrong here, the objects made so far go before the model is reimported
+			LOG("Mesh cache %s is corrupted, mesh %d is out of range, reimporting", cachePath.c_str(), i);
+			for (ComponentMesh* loaded : meshes)
+				App->scene->CleanUpSelectedGameObject(loaded->owner);
+			return false;
+		}
+		cursor += bytes;
+		remaining -= bytes;
 	}
-	else 
-		LOG("Error loading scene %s", path);
 
-	RELEASE_ARRAY(buffer);
+	for (ComponentMesh* mesh : meshes)
+	{
+		LoadMaterial(mesh->owner, mesh);
+		SetImportRotation(mesh->owner);
+	}
+
+	ProcessMeshes(meshes);
 
+	LOG("Model loaded from %s in %f seconds", cachePath.c_str(), importTimer.ReadSec());
 	return true;
 }
 
+bool ModuleImport::SaveMeshCache(const std::string& cachePath, const std::vector<ComponentMesh*>& meshes, uint64 sourceModTime, uint64 sourceSize) const
+{
+	PROFILE_FUNCTION();
+	MeshCacheHeader header;
+	memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+	header.version = MESH_CACHE_VERSION;
+	header.sourceModTime = sourceModTime;
+	header.sourceSize = sourceSize;
+	header.numMeshes = (uint)meshes.size();
+
+	std::vector<char> fileBuffer(sizeof(header));
+	memcpy(&fileBuffer[0], &header, sizeof(header));
+
+	for (const ComponentMesh* mesh : meshes)
+	{
+		const std::string& name = mesh->owner->name;
+		uint nameLength = (uint)name.size();
+		const char* nameLengthBytes = (const char*)&nameLength;
+		fileBuffer.insert(fileBuffer.end(), nameLengthBytes, nameLengthBytes + sizeof(nameLength));
+		fileBuffer.insert(fileBuffer.end(), name.begin(), name.end());
+
+		char* meshBuffer = nullptr;
+		uint64 size = MeshImporter::Save(mesh, &meshBuffer);
+		fileBuffer.insert(fileBuffer.end(), meshBuffer, meshBuffer + size);
+		RELEASE_ARRAY(meshBuffer);
+	}
+
+	return App->fileSystem->Save(cachePath.c_str(), &fileBuffer[0], fileBuffer.size()) != 0;
+}
+
+void ModuleImport::ProcessMeshes(const std::vector<ComponentMesh*>& meshes)
+{
+	App->jobSystem->jobs.ParallelFor((uint)meshes.size(), [&](uint i)
+	{
+		PROFILE_ZONE("Process Mesh");
+		// Meshes read from the cache come already optimized, with their levels
+		if (meshes[i]->lods.empty())
+		{
+			meshes[i]->Optimize();
+			meshes[i]->GenerateLods();
+			LOG("Mesh %s optimized, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", meshes[i]->owner->name.c_str(),
+				meshes[i]->sourceCacheStats.acmr, meshes[i]->cacheStats.acmr, meshes[i]->sourceCacheStats.atvr, meshes[i]->cacheStats.atvr);
+		}
+		meshes[i]->GenerateBounds();
+		meshes[i]->ComputeNormals();
+		if (meshes[i]->bvh.IsEmpty())
+			meshes[i]->bvh.Build(meshes[i]->vertices, meshes[i]->indices);
+	});
+
+	PROFILE_ZONE("Upload Meshes");
+	for (ComponentMesh* mesh : meshes)
+	{
+		mesh->GenerateBuffers();
+		mesh->UpdateWorldBounds();
+	}
+}
+
+void ModuleImport::LoadMaterial(GameObject* gameObject, ComponentMesh* mesh)
+{
+	if (mesh->texturePath.empty())
+		return;
+
+	ComponentMaterial* materialComp = gameObject->CreateComponent<ComponentMaterial>();
+	materialComp->SetTextureAsync(mesh->texturePath);
+}
+
+void ModuleImport::SetImportRotation(GameObject* gameObject) const
+{
+	float3 newRotationEuler;
+
+	newRotationEuler.x = -90.f;
+
+	newRotationEuler.x = DEGTORAD * newRotationEuler.x;
+	newRotationEuler.y = DEGTORAD * newRotationEuler.y;
+	newRotationEuler.z = DEGTORAD * newRotationEuler.z;
+
+	gameObject->transform->SetRotation(newRotationEuler);
+}
+
 void ModuleImport::Load(std::string path)
 {
 	if (App->fileSystem->Exists(path))
@@ -269,115 +407,293 @@ bool ModuleImport::CleanUp()
 
 	return true;
 }
-//#pragma endregion
-//#pragma region MeshImporter
-//void MeshImporter::Import(const aiMesh* assimpMesh, ComponentMesh* ourMesh)
-//{
-//	Timer imporTimer; imporTimer.Start();
-//
-//	ourMesh->numVertices = assimpMesh->mNumVertices;
-//	ourMesh->vertices.resize(assimpMesh->mNumVertices);
-//
-//	memcpy(&ourMesh->vertices[0], assimpMesh->mVertices, sizeof(float3) * assimpMesh->mNumVertices);
-//	LOG("New mesh with %d vertices", assimpMesh->mNumVertices);
-//
-//	// -- Copying faces --//
-//	if (assimpMesh->HasFaces()) 
-//	{
-//		ourMesh->numIndices = assimpMesh->mNumFaces * 3;
-//		ourMesh->indices.resize(ourMesh->numIndices);
-//
-//		for (size_t i = 0; i < assimpMesh->mNumFaces; i++)
-//		{
-//			if (assimpMesh->mFaces[i].mNumIndices != 3) 
-//			{
-//				LOG("WARNING, geometry face with != 3 indices!")
-//			}
-//			else 
-//			{
-//				memcpy(&ourMesh->indices[i * 3], assimpMesh->mFaces[i].mIndices, 3 * sizeof(uint));
-//			}
-//		}
-//	}
-//	// -- Copying Normals info --//
-//	if (assimpMesh->HasNormals()) 
-//	{
-//		ourMesh->normals.resize(assimpMesh->mNumVertices);
-//		memcpy(&ourMesh->normals[0], assimpMesh->mNormals, sizeof(float3) * assimpMesh->mNumVertices);
-//	}
-//	// -- Copying UV info --//
-//	if (assimpMesh->HasTextureCoords(0))
-//	{
-//		ourMesh->texCoords.resize(assimpMesh->mNumVertices);
-//		for (size_t j = 0; j < assimpMesh->mNumVertices; ++j)
-//		{
-//			memcpy(&ourMesh->texCoords[j], &assimpMesh->mTextureCoords[0][j], sizeof(float2));
-//		}
-//	}
-//	ourMesh->GenerateBuffers();
-//	LOG("The mesh was imported from Assimp in %f seconds", imporTimer.ReadSec());
-//}
-//uint64 MeshImporter::Save(const ComponentMesh* ourMesh, char** fileBuffer)
-//{
-//	uint ranges[3] = {ourMesh->numIndices, ourMesh->numVertices, ourMesh->numNormalFaces};
-//	uint size = sizeof(ranges) + sizeof(uint) * ourMesh->numIndices 
-//		+ sizeof(float3) * ourMesh->numVertices * 3
-//		+ sizeof(float3) * ourMesh->numNormalFaces * 3;
-//
-//	// Allocate Buffer
-//	char* fileBuffer = new char[size]; 
-//	char* cursor = *fileBuffer;
-//
-//	// Store ranges
-//	uint bytes = sizeof(ranges); 
-//	memcpy(cursor, ranges, bytes);
-//	cursor += bytes;
-//	// Store Indices
-//	bytes = sizeof(uint) * ourMesh->numIndices;
-//	memcpy(cursor, &ourMesh->indices, bytes);
-//	cursor += bytes;	
-//	// Store Vertex
-//	bytes = sizeof(float3) * ourMesh->numVertices;
-//	memcpy(cursor, &ourMesh->vertices, bytes);
-//	cursor += bytes;	
-//	// Store Normals
-//	bytes = sizeof(float3) * ourMesh->numNormalFaces;
-//	memcpy(cursor, &ourMesh->normals, bytes);
-//	cursor += bytes;
-//
-//	return size;
-//}
-//void MeshImporter::Load(const char* fileBuffer, ComponentMesh* ourMesh)
-//{
-//	Timer imporTimer; imporTimer.Start();
-//	const char* cursor = fileBuffer;
-//
-//	// Amount of Indices / Vertices / Normals
-//	uint ranges[3];
-//	uint bytes = sizeof(ranges);
-//	memcpy(ranges, cursor, bytes);
-//	cursor += bytes;
-//
-//	ourMesh->numIndices = ranges[0];
-//	ourMesh->numVertices = ranges[1];
-//	ourMesh->numNormalFaces = ranges[2];
-//
-//	// Load indices
-//	bytes = sizeof(uint) * ourMesh->numIndices;
-//	ourMesh->indices = new uint[ourMesh->numIndices];
-//	memcpy(&ourMesh->indices, cursor, bytes);
-//	cursor += bytes;		
-//	// Load Vertices
-//	bytes = sizeof(float3) * ourMesh->numVertices;
-//	ourMesh->vertices = new float3[ourMesh->numVertices];
-//	memcpy(&ourMesh->vertices, cursor, bytes);
-//	cursor += bytes;
-//	// Load Normals
-//	bytes = sizeof(float3) * ourMesh->numNormalFaces;
-//	ourMesh->normals = new float3[ourMesh->numNormalFaces];
-//	memcpy(&ourMesh->normals, cursor, bytes);
-//	cursor += bytes;
-//
-//	LOG("Mesh was loaded succesfully in %f seconds", )
-//}
+#pragma endregion
+#pragma region MeshImporter
+void MeshImporter::Import(const aiMesh* assimpMesh, ComponentMesh* ourMesh)
+{
+	PROFILE_FUNCTION();
+	ourMesh->numVertices = assimpMesh->mNumVertices;
+	ourMesh->vertices.resize(assimpMesh->mNumVertices);
+
+	memcpy(&ourMesh->vertices[0], assimpMesh->mVertices, sizeof(float3) * assimpMesh->mNumVertices);
+	LOG("New mesh with %d vertices", assimpMesh->mNumVertices);
+
+	// -- Copying faces --//
+	if (assimpMesh->HasFaces()) 
+	{
+		ourMesh->numIndices = assimpMesh->mNumFaces * 3;
+		ourMesh->indices.resize(ourMesh->numIndices);
+
+		for (size_t i = 0; i < assimpMesh->mNumFaces; i++)
+		{
+			if (assimpMesh->mFaces[i].mNumIndices != 3) 
+			{
+				LOG("WARNING, geometry face with != 3 indices!")
+			}
+			else 
+			{
+				memcpy(&ourMesh->indices[i * 3], assimpMesh->mFaces[i].mIndices, 3 * sizeof(uint));
+			}
+		}
+	}
+	// -- Copying Normals info --//
+	if (assimpMesh->HasNormals()) 
+	{
+		ourMesh->normals.resize(assimpMesh->mNumVertices);
+		memcpy(&ourMesh->normals[0], assimpMesh->mNormals, sizeof(float3) * assimpMesh->mNumVertices);
+	}
+	// -- Copying UV info --//
+	if (assimpMesh->HasTextureCoords(0))
+	{
+		ourMesh->texCoords.resize(assimpMesh->mNumVertices);
+		for (size_t j = 0; j < assimpMesh->mNumVertices; ++j)
+		{
+			memcpy(&ourMesh->texCoords[j], &assimpMesh->mTextureCoords[0][j], sizeof(float2));
+		}
+	}
+}
+
+// Indices are 16 bit for meshes that fit, normals and uvs use the packed vertex encodings
+static uint64 GetMeshBlockSize(const uint ranges[9])
+{
+	const uint64 indexSize = ranges[1] <= VertexEncoding::MAX_SHORT_INDEX_VERTICES ? sizeof(unsigned short) : sizeof(uint);
+	return sizeof(uint) * 9
+		+ sizeof(char) * ranges[4]
+		+ indexSize * (ranges[0] + ranges[8])
+		+ sizeof(MeshLod) * ranges[7]
+		+ sizeof(float3) * ranges[1]
+		+ sizeof(uint) * ranges[2]
+		+ sizeof(uint) * ranges[3]
+		+ sizeof(MeshBVHNode) * ranges[5]
+		+ sizeof(uint) * ranges[6]
+		+ sizeof(VertexCacheStats) * 2;
+}
+
+static char* SaveIndices(char* cursor, const std::vector<uint>& indices, bool shortIndices)
+{
+	if (!shortIndices)
+	{
+		const uint64 bytes = sizeof(uint) * indices.size();
+		if (bytes) memcpy(cursor, &indices[0], bytes);
+		return cursor + bytes;
+	}
+
+	for (uint index : indices)
+	{
+		const unsigned short shortIndex = (unsigned short)index;
+		memcpy(cursor, &shortIndex, sizeof(shortIndex));
+		cursor += sizeof(shortIndex);
+	}
+	return cursor;
+}
+
+static const char* LoadIndices(const char* cursor, uint count, bool shortIndices, std::vector<uint>& indices)
+{
+	indices.resize(count);
+	if (!shortIndices)
+	{
+		const uint64 bytes = sizeof(uint) * count;
+		if (bytes) memcpy(&indices[0], cursor, bytes);
+		return cursor + bytes;
+	}
+
+	for (uint i = 0; i < count; ++i, cursor += sizeof(unsigned short))
+	{
+		unsigned short shortIndex;
+		memcpy(&shortIndex, cursor, sizeof(shortIndex));
+		indices[i] = shortIndex;
+	}
+	return cursor;
+}
+
+// Sizes only prove the block fits in the file, the contents are indices into each other
+static bool IsLoadedMeshValid(const ComponentMesh* mesh)
+{
+	// Import leaves normals and uvs empty when the model has none
+	if ((!mesh->normals.empty() && mesh->normals.size() != mesh->numVertices)
+		|| (!mesh->texCoords.empty() && mesh->texCoords.size() != mesh->numVertices))
+		return false;
+
+	for (uint index : mesh->indices)
+	{
+		if (index >= mesh->numVertices)
+			return false;
+	}
+	for (uint index : mesh->lodIndices)
+	{
+		if (index >= mesh->numVertices)
+			return false;
+	}
+
+	// A level reads either the full mesh or the simplified indices, never across both
+	const uint64 numIndices = mesh->indices.size();
+	for (const MeshLod& lod : mesh->lods)
+	{
+		const uint64 end = (uint64)lod.firstIndex + lod.numIndices;
+		if (lod.firstIndex < numIndices ? end > numIndices : end > numIndices + mesh->lodIndices.size())
+			return false;
+	}
+
+	return mesh->bvh.IsValid((uint)mesh->indices.size() / 3);
+}
+
+uint64 MeshImporter::Save(const ComponentMesh* ourMesh, char** fileBuffer)
+{
+	// Amount of Indices / Vertices / Normals / UVs / texture path characters / BVH nodes / BVH triangles / LODs / LOD indices
+	uint ranges[9] = { ourMesh->numIndices, ourMesh->numVertices, (uint)ourMesh->normals.size(), (uint)ourMesh->texCoords.size(), (uint)ourMesh->texturePath.size(),
+		(uint)ourMesh->bvh.nodes.size(), (uint)ourMesh->bvh.triangles.size(), (uint)ourMesh->lods.size(), (uint)ourMesh->lodIndices.size() };
+	const bool shortIndices = ranges[1] <= VertexEncoding::MAX_SHORT_INDEX_VERTICES;
+	uint64 size = GetMeshBlockSize(ranges);
+
+	// Allocate Buffer
+	*fileBuffer = new char[size];
+	char* cursor = *fileBuffer;
+
+	// Store ranges
+	uint64 bytes = sizeof(ranges);
+	memcpy(cursor, ranges, bytes);
+	cursor += bytes;
+	// Store texture path
+	bytes = sizeof(char) * ranges[4];
+	memcpy(cursor, ourMesh->texturePath.c_str(), bytes);
+	cursor += bytes;
+	// Store Indices
+	cursor = SaveIndices(cursor, ourMesh->indices, shortIndices);
+	// Store Vertex
+	bytes = sizeof(float3) * ranges[1];
+	if (bytes) memcpy(cursor, &ourMesh->vertices[0], bytes);
+	cursor += bytes;
+	// Store Normals
+	for (uint i = 0; i < ranges[2]; ++i, cursor += sizeof(uint))
+	{
+		const uint normal = VertexEncoding::PackNormal(ourMesh->normals[i]);
+		memcpy(cursor, &normal, sizeof(normal));
+	}
+	// Store UVs
+	for (uint i = 0; i < ranges[3]; ++i, cursor += sizeof(uint))
+	{
+		const uint uv = VertexEncoding::PackTexCoord(ourMesh->texCoords[i]);
+		memcpy(cursor, &uv, sizeof(uv));
+	}
+	// Store BVH nodes
+	bytes = sizeof(MeshBVHNode) * ranges[5];
+	if (bytes) memcpy(cursor, &ourMesh->bvh.nodes[0], bytes);
+	cursor += bytes;
+	// Store BVH triangle order
+	bytes = sizeof(uint) * ranges[6];
+	if (bytes) memcpy(cursor, &ourMesh->bvh.triangles[0], bytes);
+	cursor += bytes;
+	// Store LOD ranges and their indices
+	bytes = sizeof(MeshLod) * ranges[7];
+	if (bytes) memcpy(cursor, &ourMesh->lods[0], bytes);
+	cursor += bytes;
+	cursor = SaveIndices(cursor, ourMesh->lodIndices, shortIndices);
+	// Store vertex cache statistics from the import
+	memcpy(cursor, &ourMesh->sourceCacheStats, sizeof(VertexCacheStats));
+	cursor += sizeof(VertexCacheStats);
+	memcpy(cursor, &ourMesh->cacheStats, sizeof(VertexCacheStats));
+	cursor += sizeof(VertexCacheStats);
+
+	return size;
+}
+
+uint64 MeshImporter::GetBlockSize(const char* fileBuffer, uint64 size)
+{
+	uint ranges[9];
+	if (size < sizeof(ranges)) return 0;
+	memcpy(ranges, fileBuffer, sizeof(ranges));
+
+	const uint64 total = GetMeshBlockSize(ranges);
+	return size < total ? 0 : total;
+}
+
+uint64 MeshImporter::Load(const char* fileBuffer, uint64 size, ComponentMesh* ourMesh)
+{
+	const char* cursor = fileBuffer;
+
+	const uint64 total = GetBlockSize(fileBuffer, size);
+	if (total == 0) return 0;
+
+	// Amount of Indices / Vertices / Normals / UVs / texture path characters / BVH nodes / BVH triangles / LODs / LOD indices
+	uint ranges[9];
+	uint64 bytes = sizeof(ranges);
+	memcpy(ranges, cursor, bytes);
+	cursor += bytes;
+
+	ourMesh->numIndices = ranges[0];
+	ourMesh->numVertices = ranges[1];
+
+	// Load texture path
+	bytes = sizeof(char) * ranges[4];
+	ourMesh->texturePath.assign(cursor, bytes);
+	cursor += bytes;
+	// Load indices
+	const bool shortIndices = ranges[1] <= VertexEncoding::MAX_SHORT_INDEX_VERTICES;
+	cursor = LoadIndices(cursor, ranges[0], shortIndices, ourMesh->indices);
+	// Load Vertices
+	bytes = sizeof(float3) * ranges[1];
+	ourMesh->vertices.resize(ranges[1]);
+	if (bytes) memcpy(&ourMesh->vertices[0], cursor, bytes);
+	cursor += bytes;
+	// Load Normals
+	ourMesh->normals.resize(ranges[2]);
+	for (uint i = 0; i < ranges[2]; ++i, cursor += sizeof(uint))
+	{
+		uint normal;
+		memcpy(&normal, cursor, sizeof(normal));
+		ourMesh->normals[i] = VertexEncoding::UnpackNormal(normal);
+	}
+	// Load UVs
+	ourMesh->texCoords.resize(ranges[3]);
+	for (uint i = 0; i < ranges[3]; ++i, cursor += sizeof(uint))
+	{
+		uint uv;
+		memcpy(&uv, cursor, sizeof(uv));
+		ourMesh->texCoords[i] = VertexEncoding::UnpackTexCoord(uv);
+	}
+	// Load BVH nodes
+	bytes = sizeof(MeshBVHNode) * ranges[5];
+	ourMesh->bvh.nodes.resize(ranges[5]);
+	if (bytes) memcpy(&ourMesh->bvh.nodes[0], cursor, bytes);
+	cursor += bytes;
+	// Load BVH triangle order
+	bytes = sizeof(uint) * ranges[6];
+	ourMesh->bvh.triangles.resize(ranges[6]);
+	if (bytes) memcpy(&ourMesh->bvh.triangles[0], cursor, bytes);
+	cursor += bytes;
+	// Load LOD ranges and their indices
+	bytes = sizeof(MeshLod) * ranges[7];
+	ourMesh->lods.resize(ranges[7]);
+	if (bytes) memcpy(&ourMesh->lods[0], cursor, bytes);
+	cursor += bytes;
+	cursor = LoadIndices(cursor, ranges[8], shortIndices, ourMesh->lodIndices);
+	// Load vertex cache statistics
+	memcpy(&ourMesh->sourceCacheStats, cursor, sizeof(VertexCacheStats));
+	cursor += sizeof(VertexCacheStats);
+	memcpy(&ourMesh->cacheStats, cursor, sizeof(VertexCacheStats));
+	cursor += sizeof(VertexCacheStats);
+
+	return IsLoadedMeshValid(ourMesh) ? total : 0;
+}
+
+std::string MeshImporter::GetCachePath(const char* assetPath)
+{
+	std::string fileName;
+	App->fileSystem->SplitFilePath(assetPath, nullptr, &fileName);
+
+	// Models with the same name in different folders must not share a cache, FNV-1a of the full path
+	uint hash = 2166136261u;
+	for (const char* c = assetPath; *c != '\0'; ++c)
+		hash = (hash ^ (unsigned char)*c) * 16777619u;
+
+	char suffix[10];
+	sprintf_s(suffix, 10, "_%08x", hash);
+	return std::string("Library/Meshes/") + fileName + suffix + "." + MESH_CACHE_EXTENSION;
+}
+
+std::string MeshImporter::GetGeometryKey(const std::string& cachePath, uint meshIndex, uint64 sourceModTime)
+{
+	// The modification time keeps a reimported model from picking up the buffers of the old one
+	return cachePath + "#" + std::to_string(meshIndex) + "@" + std::to_string(sourceModTime);
+}
 #pragma endregion
\ No newline at end of file
@@ -1,12 +1,14 @@
 #pragma once
 #include "Module.h"
 #include <string>
+#include <vector>
 
 struct aiNode;
 class aiScene;
 class aiMaterial;
 class aiMesh;
 
+class GameObject;
 class ComponentMesh;
 class ComponentMaterial;
 class ComponentTransform;
@@ -28,19 +30,42 @@ public:
 
 	void FindNodeName(const aiScene* scene, const size_t i, std::string& name);
 
+	std::vector<std::string> check;
 
+private:
 
-	std::vector<std::string> check;
+	// Binary mesh cache in Library/Meshes
+	bool LoadMeshCache(const std::string& cachePath, uint64 sourceModTime, uint64 sourceSize);
+	bool SaveMeshCache(const std::string& cachePath, const std::vector<ComponentMesh*>& meshes, uint64 sourceModTime, uint64 sourceSize) const;
+
+	void LoadMaterial(GameObject* gameObject, ComponentMesh* mesh);
+	void SetImportRotation(GameObject* gameObject) const;
+
+	// CPU side mesh processing runs on the workers, GL uploads stay on the main thread
+	void ProcessMeshes(const std::vector<ComponentMesh*>& meshes);
+};
+
+// Bump the version whenever the mesh block layout changes, old caches are then rebuilt from the source model
+#define MESH_CACHE_MAGIC "CAPM"
+#define MESH_CACHE_VERSION 5
+#define MESH_CACHE_EXTENSION "capimesh"
+
+struct MeshCacheHeader
+{
+	char magic[4];
+	uint version;
+	uint64 sourceModTime;
+	uint64 sourceSize;
+	uint numMeshes;
 };
 
 namespace MeshImporter
 {
-	//void Import(const aiMesh* assimpMesh, ComponentMesh* ourMesh);
-	//uint64 Save(const ComponentMesh* ourMesh, char** fileBuffer);
-	//void Load(const char* fileBuffer, ComponentMesh* ourMesh);
-	
-	
-	/*GameObject* ImportFBX(const char* path);
-	GameObject* PreorderChildren(const aiScene* scene, aiNode* node, aiNode* parentNode, GameObject* parentGO, const char* path);
-	void LoadTransform(aiNode* node, ComponentTransform* transform);*/
+	void Import(const aiMesh* assimpMesh, ComponentMesh* ourMesh);
+	uint64 Save(const ComponentMesh* ourMesh, char** fileBuffer);
+	uint64 Load(const char* fileBuffer, uint64 size, ComponentMesh* ourMesh); //returns the amount of bytes read, 0 on error
+	uint64 GetBlockSize(const char* fileBuffer, uint64 size); // Of the saved mesh at the buffer, 0 if it is truncated
+
+	std::string GetCachePath(const char* assetPath);
+	std::string GetGeometryKey(const std::string& cachePath, uint meshIndex, uint64 sourceModTime); // Shared GPU buffers, see GeometryCache
 }
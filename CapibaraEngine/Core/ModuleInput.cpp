@@ -154,15 +154,18 @@ update_status ModuleInput::PreUpdate(float dt)
 					}
 					else
 					{
-						TextureObject texture = App->textures->Load(realFileName);
 						if (App->editor->gameobjectSelected)
 						{
 							if (ComponentMaterial* material = App->editor->gameobjectSelected->GetComponent<ComponentMaterial>())
 							{
-								material->SetTexture(texture);
+								material->SetTextureAsync(realFileName);
 							}
 
 						}
+						else
+						{
+							App->textures->LoadAsync(realFileName);
+						}
 					}
 				}
 			};
@@ -0,0 +1,71 @@
+#include "ModuleJobSystem.h"
+#include "Application.h"
+#include "ImGui/imgui.h"
+#include "SDL/include/SDL_cpuinfo.h"
+
+ModuleJobSystem::ModuleJobSystem(Application* app, bool start_enabled) : Module(app, start_enabled)
+{}
+
+ModuleJobSystem::~ModuleJobSystem()
+{}
+
+bool ModuleJobSystem::Init()
+{
+	// Main thread also runs jobs while waiting, so one thread less
+	const int numCPUs = SDL_GetCPUCount();
+	jobs.Start(numCPUs > 1 ? numCPUs - 1 : 0);
+	LOG("Job system workers: %d", jobs.GetNumWorkers());
+
+	return true;
+}
+
+update_status ModuleJobSystem::PreUpdate(float dt)
+{
+	jobs.GetStats(lastFrameStats);
+
+	return UPDATE_CONTINUE;
+}
+
+bool ModuleJobSystem::CleanUp()
+{
+	jobs.Stop();
+
+	return true;
+}
+
+void ModuleJobSystem::OnGui()
+{
+	if (ImGui::CollapsingHeader("Jobs"))
+	{
+		ImGui::Text("Workers: %d", jobs.GetNumWorkers());
+		if (ImGui::Checkbox("Single Thread", &singleThreaded))
+			jobs.SetSingleThreaded(singleThreaded);
+
+		ImGui::Separator();
+		for (uint i = 0; i < lastFrameStats.size(); ++i)
+		{
+			if (i == 0)
+				ImGui::Text("Main: %d jobs, %d stolen", lastFrameStats[i].executed, lastFrameStats[i].stolen);
+			else
+				ImGui::Text("Worker %d: %d jobs, %d stolen", i, lastFrameStats[i].executed, lastFrameStats[i].stolen);
+		}
+	}
+}
+
+void ModuleJobSystem::OnLoad(const JSONReader& reader)
+{
+	if (reader.HasMember("jobs"))
+	{
+		const auto& config = reader["jobs"];
+		LOAD_JSON_BOOL(singleThreaded)
+		jobs.SetSingleThreaded(singleThreaded);
+	}
+}
+
+void ModuleJobSystem::OnSave(JSONWriter& writer) const
+{
+	writer.String("jobs");
+	writer.StartObject();
+	SAVE_JSON_BOOL(singleThreaded)
+	writer.EndObject();
+}
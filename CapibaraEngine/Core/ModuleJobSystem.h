@@ -0,0 +1,31 @@
+#pragma once
+#include "Module.h"
+#include "Globals.h"
+#include "JobSystem.h"
+
+#include <vector>
+
+// Owns the engine job system. Created first so every other module can use it from Init. It is also the
+// first one cleaned up: the workers finish what is queued and stop, and jobs queued by a later CleanUp
+// run on the main thread while it waits for them.
+class ModuleJobSystem : public Module
+{
+public:
+	ModuleJobSystem(Application* app, bool start_enabled = true);
+	~ModuleJobSystem();
+
+	bool Init() override;
+	update_status PreUpdate(float dt) override;
+	bool CleanUp() override;
+	void OnGui() override;
+
+	void OnLoad(const JSONReader& reader) override;
+	void OnSave(JSONWriter& writer) const override;
+
+public:
+	JobSystem jobs;
+
+private:
+	std::vector<JobThreadStats> lastFrameStats;
+	bool singleThreaded = false; // Every job runs in place, in order
+};
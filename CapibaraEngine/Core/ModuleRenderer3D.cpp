@@ -6,10 +6,8 @@
 #include "ModuleScene.h"
 #include "ModuleEditor.h"
 
-#include "glew.h"
-#include "SDL/include/SDL_opengl.h"
-#include <gl/GL.h>
-#include <gl/GLU.h>
+#include "RenderBackendGL.h"
+#include "RenderBackendNull.h"
 
 ModuleRenderer3D::ModuleRenderer3D(Application* app, bool start_enabled) : Module(app, start_enabled)
 {
@@ -20,106 +18,42 @@ ModuleRenderer3D::ModuleRenderer3D(Application* app, bool start_enabled) : Modul
 	useLighting = true;
 	useTexture = true;
 	wireframeMode = false;
+	useLods = true;
+	useOcclusion = true;
+
+	context = NULL;
+	if (App->headless)
+		backend = new RenderBackendNull();
+	else
+		backend = new RenderBackendGL();
 }
 
 // Destructor
 ModuleRenderer3D::~ModuleRenderer3D()
-{}
+{
+	RELEASE(backend);
+}
 
 // Called before render is available
 bool ModuleRenderer3D::Init()
 {
 	LOG("Creating 3D Renderer context");
 	bool ret = true;
-		
-	//Create context
-	context = SDL_GL_CreateContext(App->window->window);
-	if(context == NULL)
-	{
-		LOG("OpenGL context could not be created! SDL_Error: %s\n", SDL_GetError());
-		ret = false;
-	}
 
-	GLenum err = glewInit();
-
-	LOG("Using Glew %s", glewGetString(GLEW_VERSION));
-	LOG("Vendor: %s", glGetString(GL_VENDOR));
-	LOG("Renderer: %s", glGetString(GL_RENDERER));
-	LOG("OpenGL version supported %s", glGetString(GL_VERSION));
-	LOG("GLSL: %s\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
-	
-
-	if(ret == true)
+	if (!App->headless)
 	{
-		//Use Vsync
-		if(VSYNC && SDL_GL_SetSwapInterval(1) < 0)
-			LOG("Warning: Unable to set VSync! SDL Error: %s\n", SDL_GetError());
-
-		//Initialize Projection Matrix
-		glMatrixMode(GL_PROJECTION);
-		glLoadIdentity();
-
-		//Check for error
-		GLenum error = glGetError();
-		if(error != GL_NO_ERROR)
-		{
-			LOG("Error initializing OpenGL! %s\n", gluErrorString(error));
-			ret = false;
-		}
-
-		//Initialize Modelview Matrix
-		glMatrixMode(GL_MODELVIEW);
-		glLoadIdentity();
-
-		//Check for error
-		error = glGetError();
-		if(error != GL_NO_ERROR)
-		{
-			LOG("Error initializing OpenGL! %s\n", gluErrorString(error));
-			ret = false;
-		}
-		
-		glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);
-		glClearDepth(1.0f);
-		
-		//Initialize clear color
-		glClearColor(0.f, 0.f, 0.f, 1.f);
-
-		//Initialize BlendFunc
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-		//Check for error
-		error = glGetError();
-		if(error != GL_NO_ERROR)
+		//Create context
+		context = SDL_GL_CreateContext(App->window->window);
+		if (context == NULL)
 		{
-			LOG("Error initializing OpenGL! %s\n", gluErrorString(error));
+			LOG("OpenGL context could not be created! SDL_Error: %s\n", SDL_GetError());
 			ret = false;
 		}
-		
-		GLfloat LightModelAmbient[] = {0.3f, 0.3f, 0.3f, 1.0f};
-		glLightModelfv(GL_LIGHT_MODEL_AMBIENT, LightModelAmbient);
-		
-		lights[0].ref = GL_LIGHT0;
-		lights[0].ambient.Set(0.25f, 0.25f, 0.25f, 1.0f);
-		lights[0].diffuse.Set(0.9f, 0.9f, 0.9f, 1.0f);
-		lights[0].SetPos(0.0f, 0.0f, 2.5f);
-		lights[0].Init();
-		lights[0].Active(true);
-
-		
-		GLfloat MaterialAmbient[] = {1.0f, 1.0f, 1.0f, 1.0f};
-		glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, MaterialAmbient);
-
-		GLfloat MaterialDiffuse[] = {1.0f, 1.0f, 1.0f, 1.0f};
-		glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, MaterialDiffuse);
-		
-		glEnable(GL_DEPTH_TEST);
-		glEnable(GL_CULL_FACE);
-		glEnable(GL_LIGHTING);
-		glEnable(GL_COLOR_MATERIAL);
-		glEnable(GL_TEXTURE_2D);
 	}
 
+	if (ret == true)
+		ret = backend->Init();
+
 	// Projection matrix for
 	OnResize(SCREEN_WIDTH, SCREEN_HEIGHT);
 
@@ -128,15 +62,11 @@ bool ModuleRenderer3D::Init()
 
 bool ModuleRenderer3D::Start()
 {
-	DrawingModes(depthTestEnabled, GL_DEPTH_TEST);
-
-	DrawingModes(cullFace, GL_CULL_FACE);
-
-	DrawingModes(useLighting, GL_LIGHTING);
-
-	DrawingModes(useTexture, GL_TEXTURE_2D);
-
-	wireframeMode ? glPolygonMode(GL_FRONT_AND_BACK, GL_LINE) : glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	backend->SetState(RenderState::DEPTH_TEST, depthTestEnabled);
+	backend->SetState(RenderState::CULL_FACE, cullFace);
+	backend->SetState(RenderState::LIGHTING, useLighting);
+	backend->SetState(RenderState::TEXTURE_2D, useTexture);
+	backend->SetState(RenderState::WIREFRAME, wireframeMode);
 
 	return true;
 }
@@ -144,21 +74,14 @@ bool ModuleRenderer3D::Start()
 // PreUpdate: clear buffer
 update_status ModuleRenderer3D::PreUpdate(float dt)
 {
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	backend->Clear(Color(0.3f, 0.3f, 0.3f, 1.0f));
 
 	// Recalculate matrix -------------
 	App->camera->CalculateViewMatrix();
-
-	glMatrixMode(GL_PROJECTION);
-	glLoadMatrixf(App->camera->cameraFrustum.ProjectionMatrix().Transposed().ptr());
-	glMatrixMode(GL_MODELVIEW);
-	glLoadMatrixf(App->camera->viewMatrix.Transposed().ptr());
+	backend->SetCamera(App->camera->viewMatrix, App->camera->cameraFrustum.ProjectionMatrix());
 
 	// light 0 on cam pos
-	lights[0].SetPos(App->camera->position.x, App->camera->position.y, App->camera->position.z);
-
-	for(uint i = 0; i < MAX_LIGHTS; ++i)
-		lights[i].Render();
+	backend->SetLightPosition(App->camera->position);
 
 	return UPDATE_CONTINUE;
 }
@@ -166,7 +89,7 @@ update_status ModuleRenderer3D::PreUpdate(float dt)
 // PostUpdate present buffer to screen
 update_status ModuleRenderer3D::PostUpdate(float dt)
 {
-	SDL_GL_SwapWindow(App->window->window);
+	backend->EndFrame();
 
 	return UPDATE_CONTINUE;
 }
@@ -176,7 +99,14 @@ bool ModuleRenderer3D::CleanUp()
 {
 	LOG("Destroying 3D Renderer");
 
-	SDL_GL_DeleteContext(context);
+	const RenderStats& stats = backend->GetTotalStats();
+	LOG("%s backend: %llu frames, %llu draw calls, %llu triangles, %llu lines, %llu instances, %llu state changes, %llu uploads (%llu KB)",
+		backend->GetName(), stats.frames, stats.drawCalls, stats.triangles, stats.lines, stats.instances, stats.stateChanges, stats.uploads, stats.uploadedBytes / 1024);
+
+	backend->CleanUp();
+
+	if (context != NULL)
+		SDL_GL_DeleteContext(context);
 
 	return true;
 }
@@ -184,7 +114,7 @@ bool ModuleRenderer3D::CleanUp()
 
 void ModuleRenderer3D::OnResize(int width, int height)
 {
-	glViewport(0, 0, width, height);
+	backend->SetViewport(0, 0, width, height);
 	App->camera->RecalculateProjection();
 }
 
@@ -193,20 +123,33 @@ void ModuleRenderer3D::OnGui() {
 	{
 		ImGui::TextUnformatted("Render Options");
 		if (ImGui::Checkbox("Depth Test", &depthTestEnabled))
-			DrawingModes(depthTestEnabled, GL_DEPTH_TEST);
+			backend->SetState(RenderState::DEPTH_TEST, depthTestEnabled);
 
 		if (ImGui::Checkbox("Cull Face", &cullFace))
-			DrawingModes(cullFace, GL_CULL_FACE);
+			backend->SetState(RenderState::CULL_FACE, cullFace);
 
 		if (ImGui::Checkbox("Lighting ON/OFF", &useLighting))
-			DrawingModes(useLighting, GL_LIGHTING);
+			backend->SetState(RenderState::LIGHTING, useLighting);
 
 		if (ImGui::Checkbox("Texture Draw", &useTexture))
-			DrawingModes(useTexture, GL_TEXTURE_2D);
-
-		if (ImGui::Checkbox("Wireframe Mode", &wireframeMode)) {
-			wireframeMode ? glPolygonMode(GL_FRONT_AND_BACK, GL_LINE) : glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		}
+			backend->SetState(RenderState::TEXTURE_2D, useTexture);
+
+		if (ImGui::Checkbox("Wireframe Mode", &wireframeMode))
+			backend->SetState(RenderState::WIREFRAME, wireframeMode);
+
+		ImGui::Checkbox("Mesh LODs", &useLods);
+		ImGui::Checkbox("Occlusion Culling", &useOcclusion);
+
+		const RenderStats& stats = backend->GetFrameStats();
+		ImGui::Separator();
+		ImGui::Text("Backend: %s", backend->GetName());
+		ImGui::Text("Draw calls: %llu  Triangles: %llu  Lines: %llu  Instances: %llu", stats.drawCalls, stats.triangles, stats.lines, stats.instances);
+		ImGui::Text("State changes: %llu  Uploads: %llu", stats.stateChanges, stats.uploads);
+		ImGui::Text("Render queue: %d packets, %d instanced, %d command lists", renderQueue.GetLastPacketCount(), renderQueue.GetLastInstancedCount(), renderQueue.GetLastListCount());
+		ImGui::Text("Shared geometries: %d", geometryCache.Size());
+		ImGui::Checkbox("Instancing", &renderQueue.useInstancing);
+		if (!backend->SupportsInstancing())
+			ImGui::TextColored(ImVec4(1.f, 1.f, 0.f, 1.f), "Not supported, copies are drawn one by one");
 	}
 }
 void ModuleRenderer3D::OnLoad(const JSONReader& reader)
@@ -218,6 +161,8 @@ void ModuleRenderer3D::OnLoad(const JSONReader& reader)
 		LOAD_JSON_BOOL(cullFace)
 		LOAD_JSON_BOOL(useTexture)
 		LOAD_JSON_BOOL(wireframeMode)
+		LOAD_JSON_BOOL(useLods)
+		LOAD_JSON_BOOL(useOcclusion)
 		LOAD_JSON_BOOL(vsyncActive)
 	}
 }
@@ -231,11 +176,9 @@ void ModuleRenderer3D::OnSave(JSONWriter& writer) const
 	SAVE_JSON_BOOL(useLighting)
 	SAVE_JSON_BOOL(useTexture)
 	SAVE_JSON_BOOL(wireframeMode)
+	SAVE_JSON_BOOL(useLods)
+	SAVE_JSON_BOOL(useOcclusion)
 	SAVE_JSON_BOOL(vsyncActive)
 	writer.EndObject();
 }
 
-
-void ModuleRenderer3D::DrawingModes(bool currentState, int glMode) {
-	currentState ? glEnable(glMode) : glDisable(glMode);
-}
\ No newline at end of file
@@ -1,10 +1,9 @@
 #pragma once
 #include "Module.h"
 #include "Globals.h"
-#include "Light.h"
-
-
-#define MAX_LIGHTS 8
+#include "RenderBackend.h"
+#include "RenderQueue.h"
+#include "GeometryCache.h"
 
 class ModuleRenderer3D : public Module
 {
@@ -23,11 +22,12 @@ public:
 	void OnGui() override;
 	void OnLoad(const JSONReader& reader) override;
 	void OnSave(JSONWriter& writer) const override;
-	void DrawingModes(bool currentState, int glMode);
 
 public:
 
-	Light lights[MAX_LIGHTS];
+	RenderBackend* backend = nullptr; // OpenGL, or the null backend when running headless
+	RenderQueue renderQueue; // Meshes of the view being drawn, flushed by the scene
+	GeometryCache geometryCache;
 	SDL_GLContext context;
 
 	bool depthTestEnabled;
@@ -35,6 +35,8 @@ public:
 	bool useLighting;
 	bool useTexture;
 	bool wireframeMode;
+	bool useLods;
+	bool useOcclusion;
 	bool vsyncActive;
 
 };
\ No newline at end of file
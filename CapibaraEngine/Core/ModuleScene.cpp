@@ -1,17 +1,26 @@
 #include "Globals.h"
 #include "Application.h"
 #include "ModuleScene.h"
-#include "glew.h"
 #include "ImGui/imgui.h"
 #include "ModuleImport.h"
 #include "ModuleTextures.h"
 #include "ModuleCamera3D.h"
 #include "ModuleFileSystem.h"
 #include "ModuleEditor.h"
+#include "ModuleRenderer3D.h"
+#include "ModuleDebugDraw.h"
 #include "Component.h"
 #include "ComponentTransform.h"
+#include "ComponentMaterial.h"
+#include "ComponentMesh.h"
+#include "ComponentCamera.h"
 #include "Algorithm/Random/LCG.h"
+#include "ModuleJobSystem.h"
+#include "Profiler.h"
+#include "FrameArena.h"
 #include <stack>
+#include <set>
+#include <algorithm>
 #include <queue>
 
 ModuleScene::ModuleScene(Application* app, bool start_enabled) : Module(app, start_enabled)
@@ -62,52 +71,19 @@ bool ModuleScene::CleanUp()
 
 update_status ModuleScene::Update(float dt)
 {
-	std::queue<GameObject*> S;
-	for (GameObject* child : root->children)
 	{
-		S.push(child);
-	}
-
-	while (!S.empty())
-	{
-		GameObject* go = S.front();
-		go->Update(dt);
-		S.pop();
-		for (GameObject* child : go->children)
-		{
-			S.push(child);
-		}
+		PROFILE_ZONE("Transforms");
+		transforms.Update();
 	}
 
-	glDisable(GL_DEPTH_TEST);
+	// Materials are walked straight from their pool, no need to visit the hierarchy
+	for (Component* component : ComponentPool::Get(ComponentType::MATERIAL).GetComponents())
+		static_cast<ComponentMaterial*>(component)->ResolvePendingTexture();
 
-	if (App->editor->gameobjectSelected)
+	// Components tick once per frame, however many cameras draw the scene afterwards
 	{
-		ComponentTransform* transform = App->editor->gameobjectSelected->GetComponent<ComponentTransform>();
-		float3 pos = transform->GetPosition();
-		glLineWidth(10.f);
-		glBegin(GL_LINES);
-		glColor3f(1.f, 0.f, 0.f);
-		glVertex3f(pos.x, pos.y, pos.z);
-		glVertex3f(pos.x + transform->Right().x, pos.y + transform->Right().y, pos.z + transform->Right().z);
-		glColor3f(0.f, 0.f, 1.f);
-		glVertex3f(pos.x, pos.y, pos.z);
-		glVertex3f(pos.x + transform->Front().x, pos.y + transform->Front().y, pos.z + transform->Front().z);
-		glColor3f(0.f, 1.f, 0.f);
-		glVertex3f(pos.x, pos.y, pos.z);
-		glVertex3f(pos.x + transform->Up().x, pos.y + transform->Up().y, pos.z + transform->Up().z);
-		glEnd();
-		glLineWidth(1.f);
-	}
-
-	glEnable(GL_DEPTH_TEST);
-
-	App->editor->DrawGrid();
-	App->viewportBuffer->PostUpdate(dt);
-	if (App->editor->cameraGame != nullptr)
-	{
-		App->editor->cameraGame->DrawCamera();
-		std::queue<GameObject*> S;
+		PROFILE_ZONE("Components");
+		FrameQueue<GameObject*> S;
 		for (GameObject* child : root->children)
 		{
 			S.push(child);
@@ -123,14 +99,83 @@ update_status ModuleScene::Update(float dt)
 				S.push(child);
 			}
 		}
-		App->viewportBufferGame->PostUpdate(dt);
 	}
 
-	
+	RenderBackend* backend = App->renderer3D->backend;
+	RenderQueue& renderQueue = App->renderer3D->renderQueue;
+	const bool useLods = App->renderer3D->useLods;
+	const bool useOcclusion = App->renderer3D->useOcclusion;
+	JobSystem& jobs = App->jobSystem->jobs;
+
+	// Editor viewport, its target and camera are set in PreUpdate
+	{
+		PROFILE_ZONE("Editor View");
+		RenderView& editorView = App->camera->view;
+		editorView.Cull(App->camera->cameraFrustum, sceneTree, useOcclusion, jobs);
+		editorView.Render(backend, renderQueue, useLods, jobs);
+
+		for (ComponentMesh* mesh : editorView.GetVisibleMeshes())
+			mesh->DrawDebug();
+
+		if (App->editor->gameobjectSelected)
+		{
+			ComponentTransform* transform = App->editor->gameobjectSelected->GetComponent<ComponentTransform>();
+			App->debugDraw->Axes(transform->GetPosition(), transform->Right(), transform->Up(), transform->Front(), 10.f, false);
+		}
+
+		App->editor->DrawGrid();
+		App->debugDraw->Flush(backend);
+		App->viewportBuffer->PostUpdate(dt);
+	}
+
+	// Game viewport, culled with its own frustum
+	if (ComponentCamera* camera = App->editor->cameraGame)
+	{
+		PROFILE_ZONE("Game View");
+		camera->DrawCamera();
+		camera->view.Cull(camera->cameraFrustum, sceneTree, useOcclusion, jobs);
+		camera->view.Render(backend, renderQueue, useLods, jobs);
+		App->viewportBufferGame->PostUpdate(dt);
+	}
 
 	return UPDATE_CONTINUE;
 }
 
+void ModuleScene::OnGui()
+{
+	if (ImGui::CollapsingHeader("Scene"))
+	{
+		ImGui::Text("Scene tree: %d objects, height %d", sceneTree.GetProxyCount(), sceneTree.GetHeight());
+		ViewGui("Editor camera", App->camera->view);
+		if (const ComponentCamera* camera = App->editor->cameraGame)
+			ViewGui("Game camera", camera->view);
+		ImGui::Text("Transforms updated: %d", transforms.GetLastUpdatedCount());
+
+		if (ImGui::Button("Run culling benchmark"))
+			benchmark = FrustumCuller::RunBenchmark(100000, 50);
+
+		if (benchmark.numBoxes > 0)
+		{
+			ImGui::Text("%d boxes, %d visible", benchmark.numBoxes, benchmark.visible);
+			ImGui::Text("Scalar: %.3f ms  SIMD: %.3f ms  (x%.1f)", benchmark.scalarMs, benchmark.simdMs, benchmark.simdMs > 0.0 ? benchmark.scalarMs / benchmark.simdMs : 0.0);
+			if (!benchmark.resultsMatch)
+				ImGui::TextColored(ImVec4(1.f, 0.f, 0.f, 1.f), "Scalar and SIMD results differ!");
+		}
+	}
+}
+
+void ModuleScene::ViewGui(const char* name, const RenderView& view) const
+{
+	ImGui::Text("%s: %d candidates, %d visible", name, view.GetCandidateCount(), (int)view.GetVisibleMeshes().size());
+
+	const OcclusionStats& occlusion = view.GetOcclusionStats();
+	if (occlusion.occluders > 0)
+	{
+		ImGui::Text("  Occlusion: %d occluders (%d triangles), %d of %d occluded", occlusion.occluders, occlusion.triangles, occlusion.occluded, occlusion.tested);
+		ImGui::Text("  Setup %.3f ms  Raster %.3f ms  Hierarchy %.3f ms  Test %.3f ms", occlusion.setupMs, occlusion.rasterMs, occlusion.hierarchyMs, occlusion.testMs);
+	}
+}
+
 GameObject* ModuleScene::CreateGameObject(GameObject* parent) {
 
 	GameObject* temp = new GameObject();
@@ -202,19 +247,38 @@ bool ModuleScene::CleanUpSelectedGameObject(GameObject* selectedGameObject)
 	{
 		if (selectedGameObject != root)
 		{
-			for (int i = 0; i < gameObjectList.size(); i++)
+			// The game camera is used every frame, its object and the ones above it stay
+			if (App->editor->cameraGame != nullptr)
 			{
-				if (gameObjectList[i] == selectedGameObject && selectedGameObject->parent->name == "Root")
+				for (GameObject* go = App->editor->cameraGame->owner; go != nullptr; go = go->parent)
 				{
-					root->RemoveChild(selectedGameObject);
-					gameObjectList.erase(gameObjectList.begin() + i);
-				}
-				else
-				{
-					selectedGameObject->parent->RemoveChild(selectedGameObject);
-					gameObjectList.erase(gameObjectList.begin() + i);
+					if (go == selectedGameObject)
+					{
+						LOG("%s holds the game camera, it can not be deleted", selectedGameObject->name.c_str());
+						return false;
+					}
 				}
 			}
+
+			// The whole subtree goes away with it
+			std::set<GameObject*> deleted;
+			std::stack<GameObject*> S;
+			S.push(selectedGameObject);
+			while (!S.empty())
+			{
+				GameObject* go = S.top();
+				S.pop();
+				deleted.insert(go);
+				for (GameObject* child : go->children)
+					S.push(child);
+			}
+			gameObjectList.erase(std::remove_if(gameObjectList.begin(), gameObjectList.end(),
+				[&deleted](GameObject* go) { return deleted.find(go) != deleted.end(); }), gameObjectList.end());
+
+			selectedGameObject->parent->RemoveChild(selectedGameObject);
+
+			// Deleting also drops its meshes from the scene tree, a detached object would still be pickable
+			RELEASE(selectedGameObject);
 		}
 		else
 		{
@@ -227,6 +291,7 @@ bool ModuleScene::CleanUpSelectedGameObject(GameObject* selectedGameObject)
 
 void ModuleScene::Save()
 {
+	PROFILE_FUNCTION();
 	rapidjson::StringBuffer sceneBuffer;
 	JSONWriter writer(sceneBuffer);
 
@@ -246,6 +311,7 @@ void ModuleScene::Save()
 
 void ModuleScene::Load(const char* destinationPath)
 {
+	PROFILE_FUNCTION();
 	char* loadBuffer = nullptr;
 
 	if (App->fileSystem->Load(destinationPath, &loadBuffer))
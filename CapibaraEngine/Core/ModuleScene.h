@@ -6,6 +6,12 @@
 #include "ModuleImport.h"
 
 #include "GameObject.h"
+#include "TransformSystem.h"
+#include "AABBTree.h"
+#include "FrustumCuller.h"
+
+class RenderView;
+
 class ModuleScene : public Module
 {
 public:
@@ -14,6 +20,7 @@ public:
 	bool Start() override;
 	update_status Update(float dt) override;
 	bool CleanUp() override;
+	void OnGui() override;
 
 	GameObject* CreateGameObject(GameObject* parent = nullptr);	
 	GameObject* CreateGameObject(const std::string name, GameObject* parent = nullptr);	
@@ -27,8 +34,16 @@ public:
 
 public:
 	GameObject* root;
+	TransformSystem transforms;
+	AABBTree sceneTree;
 	std::vector<GameObject*> gameObjectList;
 	std::vector<GameObject*> rootList;
 
 	int countGO = 0;
+
+private:
+	void ViewGui(const char* name, const RenderView& view) const;
+
+private:
+	FrustumCullerBenchmark benchmark;
 };
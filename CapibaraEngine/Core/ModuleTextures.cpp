@@ -4,8 +4,12 @@
 #include "ModuleTextures.h"
 #include "ModuleFileSystem.h"
 #include "ModuleEditor.h"
+#include "PerfTimer.h"
+#include "ModuleJobSystem.h"
+#include "Profiler.h"
+#include "ImGui/imgui.h"
 
-#include "glew.h"
+#include "ModuleRenderer3D.h"
 // -- DevIL Image Library
 #include "DevIL\include\ilu.h"
 #include "DevIL\include\ilut.h"
@@ -23,58 +27,35 @@ ModuleTextures::ModuleTextures(Application* app, bool start_enabled) : Module(ap
 
 bool ModuleTextures::Start()
 {
-	GLubyte fallbackImageWhite[4] = { GLubyte(255), GLubyte(255), GLubyte(255), GLubyte(255) };
-
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	glGenTextures(1, &whiteFallback);
-	glBindTexture(GL_TEXTURE_2D, whiteFallback);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, fallbackImageWhite);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	GLubyte fallbackImageBlack[4] = { GLubyte(0), GLubyte(0), GLubyte(0), GLubyte(0) };
-
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	glGenTextures(1, &blackFallback);
-	glBindTexture(GL_TEXTURE_2D, blackFallback);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, fallbackImageBlack);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	GLubyte checkerImage[CHECKERS_HEIGHT][CHECKERS_HEIGHT][4];
+	RenderBackend* backend = App->renderer3D->backend;
+
+	const unsigned char fallbackImageWhite[4] = { 255, 255, 255, 255 };
+	whiteFallback = backend->CreateTexture(1, 1, 4, fallbackImageWhite, TextureFilter::NEAREST);
+
+	const unsigned char fallbackImageBlack[4] = { 0, 0, 0, 0 };
+	blackFallback = backend->CreateTexture(1, 1, 4, fallbackImageBlack, TextureFilter::NEAREST);
+
+	unsigned char checkerImage[CHECKERS_HEIGHT][CHECKERS_HEIGHT][4];
 
 	for (int i = 0; i < CHECKERS_HEIGHT; i++) {
 		for (int j = 0; j < CHECKERS_WIDTH; j++) {
 			int c = ((((i & 0x8) == 0) ^ (((j & 0x8)) == 0))) * 255;
-			checkerImage[i][j][0] = (GLubyte)c;
-			checkerImage[i][j][1] = (GLubyte)c;
-			checkerImage[i][j][2] = (GLubyte)c;
-			checkerImage[i][j][3] = (GLubyte)255;
+			checkerImage[i][j][0] = (unsigned char)c;
+			checkerImage[i][j][1] = (unsigned char)c;
+			checkerImage[i][j][2] = (unsigned char)c;
+			checkerImage[i][j][3] = (unsigned char)255;
 		}
 	}
 
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	glGenTextures(1, &checkers);
-	glBindTexture(GL_TEXTURE_2D, checkers);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, CHECKERS_WIDTH, CHECKERS_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, checkerImage[0]);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
+	checkers = backend->CreateTexture(CHECKERS_WIDTH, CHECKERS_HEIGHT, 4, checkerImage[0], TextureFilter::NEAREST);
 
 	if (blackFallback != 0u && whiteFallback != 0u && checkers != 0u)
 	{
 		textures.insert(std::make_pair("BLACK_FALLBACK", TextureObject("BLACK_FALLBACK", static_cast<uint>(blackFallback), 1, 1)));
 		textures.insert(std::make_pair("WHITE_BALLBACK", TextureObject("WHITE_BALLBACK", static_cast<uint>(whiteFallback), 1, 1)));
 		textures.insert(std::make_pair("CHECKERS", TextureObject("CHECKERS", static_cast<uint>(checkers), CHECKERS_WIDTH, CHECKERS_HEIGHT)));
+
+		stopDecoder = false;
 		return true;
 	}
 
@@ -85,86 +66,206 @@ bool ModuleTextures::Start()
 bool ModuleTextures::CleanUp() //can be called to reset stored textures
 {
 	LOG("Cleaning Module Textures");
+
+	// A decode job still running finishes the image it holds and leaves the rest
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stopDecoder = true;
+	}
+	App->jobSystem->jobs.Wait(decoding);
+	decodeRequests = std::queue<DecodedImage>();
+	decodedImages = std::queue<DecodedImage>();
+	pending.clear();
 	
 	for (auto& t : textures)
-		glDeleteTextures(1, &t.second.id);
+		App->renderer3D->backend->DeleteTexture(t.second.id);
 	
 	textures.clear();
+
+	// Also a reset, streaming works again once the textures are back
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stopDecoder = false;
+	}
 	LOG("Cleaning Module Textures. Done");
 	return true;
 }
 
+update_status ModuleTextures::PreUpdate(float dt)
+{
+	// Upload decoded textures until the frame budget runs out, at least one per frame
+	PerfTimer uploadTimer;
+	do
+	{
+		DecodedImage image;
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			if (decodedImages.empty())
+				break;
+			image = std::move(decodedImages.front());
+			decodedImages.pop();
+		}
+
+		pending.erase(image.path);
+		if (!image.pixels.empty())
+		{
+			Upload(image);
+			LOG("Texture streamed -> %s", image.path.c_str());
+		}
+	} while (uploadTimer.ReadMs() < uploadBudgetMs);
+
+	return UPDATE_CONTINUE;
+}
+
+void ModuleTextures::OnGui()
+{
+	if (ImGui::CollapsingHeader("Textures"))
+	{
+		ImGui::SliderFloat("Upload budget (ms)", &uploadBudgetMs, 0.1f, 16.f);
+		ImGui::Text("Loaded: %d", textures.size());
+		ImGui::Text("Streaming: %d", pending.size());
+	}
+}
+
 // Load new texture from file path
 const TextureObject& ModuleTextures::Load(const std::string& path, bool useMipMaps)
 {
 	LOG("Loading texture -> %s", path.c_str());
 
+	DecodedImage image;
+	if (Decode(path, useMipMaps, image))
+		return Upload(image);
+
+	return textures["BLACK_FALLBACK"];
+}
+
+const TextureObject& ModuleTextures::LoadAsync(const std::string& path, bool useMipMaps)
+{
+	const auto texture = textures.find(path);
+	if (texture != textures.end())
+		return (*texture).second;
+
+	if (pending.find(path) == pending.end())
+	{
+		LOG("Streaming texture -> %s", path.c_str());
+		pending.insert(path);
+
+		DecodedImage request;
+		request.path = path;
+		request.useMipMaps = useMipMaps;
+
+		bool startDecoder = false;
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			decodeRequests.push(std::move(request));
+			startDecoder = !decoderQueued;
+			decoderQueued = true;
+		}
+		if (startDecoder)
+			App->jobSystem->jobs.Run([this]() { DecodePending(); }, &decoding);
+	}
+
+	return textures["CHECKERS"];
+}
+
+bool ModuleTextures::Decode(const std::string& path, bool useMipMaps, DecodedImage& image)
+{
+	image.path = path;
+	image.useMipMaps = useMipMaps;
+
+	FileView file = App->fileSystem->Map(path.c_str());
+	if (!file.IsValid())
+		return false;
+
+	std::lock_guard<std::mutex> lock(ilMutex);
+
 	ILuint imageId;
 	ilGenImages(1, &imageId);
 	ilBindImage(imageId);
 
-	char* data;
-	uint bytes = App->fileSystem->Load(path.c_str(), &data);
-
-	if (bytes != 0)
+	bool ret = false;
+	if (ilLoadL(IL_TYPE_UNKNOWN, file.Data(), (ILuint)file.Size()))
 	{
-		if (ilLoadL(IL_TYPE_UNKNOWN, data, bytes))
+		ILinfo ImageInfo;
+		iluGetImageInfo(&ImageInfo);
+		if (ImageInfo.Origin == IL_ORIGIN_UPPER_LEFT)
+		{
+			iluFlipImage();
+		}
+
+		int channels = ilGetInteger(IL_IMAGE_CHANNELS);
+		if (channels == 3)
+		{
+			ilConvertImage(IL_RGB, IL_UNSIGNED_BYTE);
+			image.channels = 3;
+		}
+		else
 		{
-			GLuint textureId = 0;
-			glBindTexture(GL_TEXTURE_2D, 0);
-			glGenTextures(1, &textureId);
+			ilConvertImage(IL_RGBA, IL_UNSIGNED_BYTE);
+			image.channels = 4;
+		}
 
-			glBindTexture(GL_TEXTURE_2D, textureId);
+		image.width = ilGetInteger(IL_IMAGE_WIDTH);
+		image.height = ilGetInteger(IL_IMAGE_HEIGHT);
 
-			ILinfo ImageInfo;
-			iluGetImageInfo(&ImageInfo);
-			if (ImageInfo.Origin == IL_ORIGIN_UPPER_LEFT)
-			{
-				iluFlipImage();
-			}
+		const ILubyte* imageData = ilGetData();
+		image.pixels.assign(imageData, imageData + ilGetInteger(IL_IMAGE_SIZE_OF_DATA));
+		ret = true;
+	}
+	ilDeleteImages(1, &imageId);
 
-			int channels = ilGetInteger(IL_IMAGE_CHANNELS);
-			if (channels == 3)
-			{
-				ilConvertImage(IL_RGB, IL_UNSIGNED_BYTE);
-			}
-			else if (channels == 4)
-			{
-				ilConvertImage(IL_RGBA, IL_UNSIGNED_BYTE);
-			}
+	return ret;
+}
 
-			ILubyte* imageData = ilGetData();
-			int width = ilGetInteger(IL_IMAGE_WIDTH);
-			int height = ilGetInteger(IL_IMAGE_HEIGHT);
+const TextureObject& ModuleTextures::Upload(const DecodedImage& image)
+{
+	uint textureId = App->renderer3D->backend->CreateTexture(image.width, image.height, image.channels, &image.pixels[0],
+		image.useMipMaps ? TextureFilter::MIPMAPS : TextureFilter::LINEAR);
+	if (textureId == 0)
+	{
+		LOG("Error creating texture %s", image.path.c_str());
+		return textures["CHECKERS"];
+	}
 
-			glTexImage2D(GL_TEXTURE_2D, 0, ilGetInteger(IL_IMAGE_FORMAT), width, height, 0, ilGetInteger(IL_IMAGE_FORMAT), GL_UNSIGNED_BYTE, imageData);
+	// A synchronous Load may have got there while the async decode was pending, the first texture stays
+	const auto inserted = textures.insert(std::make_pair(image.path, TextureObject(image.path, static_cast<uint>(textureId), image.width, image.height)));
+	if (!inserted.second)
+		App->renderer3D->backend->DeleteTexture(textureId);
 
-			if (useMipMaps)
-			{
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	return (*inserted.first).second;
+}
 
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-				glGenerateMipmap(GL_TEXTURE_2D);
-			}
-			else
+void ModuleTextures::DecodePending()
+{
+	PROFILE_FUNCTION();
+	while (true)
+	{
+		DecodedImage request;
+		{
+			// Cleared under the lock, a request pushed after this queues a new job
+			std::lock_guard<std::mutex> lock(queueMutex);
+			if (stopDecoder || decodeRequests.empty())
 			{
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+				decoderQueued = false;
+				return;
 			}
-			ilDeleteImages(1, &imageId);
-
-			glBindTexture(GL_TEXTURE_2D, 0);
+			request = std::move(decodeRequests.front());
+			decodeRequests.pop();
+		}
 
-			textures.insert(std::make_pair(path, TextureObject(path, static_cast<uint>(textureId), width, height)));
+		if (!Decode(request.path, request.useMipMaps, request))
+		{
+			LOG("Error decoding texture %s", request.path.c_str());
+			request.pixels.clear();
+		}
 
-			delete[] data;
-			return textures[path];
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			decodedImages.push(std::move(request));
 		}
-		delete[] data;
 	}
-	return textures["BLACK_FALLBACK"];
 }
+
 const TextureObject& ModuleTextures::Get(const std::string& path)
 {
 	const auto textureId = textures.find(path);
@@ -184,4 +285,9 @@ bool ModuleTextures::Find(const std::string& path) const
 	return false;
 }
 
+bool ModuleTextures::IsPending(const std::string& path) const
+{
+	return pending.find(path) != pending.end();
+}
+
 
@@ -1,8 +1,13 @@
 #pragma once
 
 #include <map>
+#include <set>
 #include <string>
+#include <vector>
+#include <queue>
+#include <mutex>
 #include "Module.h"
+#include "JobSystem.h"
 
 struct TextureObject
 {
@@ -14,6 +19,15 @@ struct TextureObject
 	uint width = 0, height = 0;
 };
 
+// CPU side result of decoding an image, ready to be uploaded
+struct DecodedImage
+{
+	std::string path;
+	std::vector<unsigned char> pixels;
+	int width = 0, height = 0;
+	uint channels = 0; // 3 or 4, everything else is converted to RGBA
+	bool useMipMaps = false;
+};
 
 class ModuleTextures : public Module
 {
@@ -22,15 +36,45 @@ public:
 	ModuleTextures(Application* app, bool start_enabled = true);
 
 	bool Start() override;
+	update_status PreUpdate(float dt) override;
 	bool CleanUp() override;
+	void OnGui() override;
 
 	const TextureObject& Load(const std::string& path, bool useMipMaps = false);
 
+	// Returns a placeholder right away, the texture is decoded on the job system and uploaded in PreUpdate
+	const TextureObject& LoadAsync(const std::string& path, bool useMipMaps = false);
+
 	const TextureObject& Get(const std::string& path);
 
 	bool Find(const std::string& path) const;
+	bool IsPending(const std::string& path) const;
 
 	uint32 whiteFallback = 0, blackFallback = 0, checkers = 0;
 
 	std::map<const std::string, TextureObject> textures;
-};
\ No newline at end of file
+
+	float uploadBudgetMs = 2.f;
+
+private:
+
+	bool Decode(const std::string& path, bool useMipMaps, DecodedImage& image);
+	const TextureObject& Upload(const DecodedImage& image);
+
+	void DecodePending(); // Job, one at a time
+
+private:
+
+	// DevIL keeps a global bound image, only one thread may use it at a time
+	std::mutex ilMutex;
+
+	// A single decode job drains the requests, DevIL would serialize any more of them on the lock above
+	JobCounter decoding;
+	std::mutex queueMutex;
+	std::queue<DecodedImage> decodeRequests;
+	std::queue<DecodedImage> decodedImages;
+	bool decoderQueued = false;
+	bool stopDecoder = false;
+
+	std::set<std::string> pending;
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include "Module.h"
 #include "Globals.h"
+#include "RenderBackend.h"
 
 #include <string>
 
@@ -18,9 +19,7 @@ public:
 
 public:
 
-	uint frameBuffer = 0;
-	uint renderBufferoutput = 0;
-	uint texture = 0;
+	RenderTarget target;
 	bool show_viewport_window = true;
 
 };
\ No newline at end of file
@@ -29,6 +29,15 @@ bool ModuleWindow::Init()
 	LOG("Init SDL window & surface");
 	bool ret = true;
 
+	if (App->headless)
+	{
+		// No video subsystem at all, the size is still used by the viewports and the editor
+		width = SCREEN_WIDTH * SCREEN_SIZE;
+		height = SCREEN_HEIGHT * SCREEN_SIZE;
+		LOG("Headless mode, no window created");
+		return true;
+	}
+
 	if(SDL_Init(SDL_INIT_VIDEO) < 0)
 	{
 		LOG("SDL_VIDEO could not initialize! SDL_Error: %s\n", SDL_GetError());
@@ -96,6 +105,9 @@ bool ModuleWindow::Init()
 
 bool ModuleWindow::Start()
 {
+	if (window == NULL)
+		return true;
+
 	if (fullscreen) 
 		SDL_SetWindowFullscreen(window, SDL_WINDOW_FULLSCREEN);
 	else
@@ -0,0 +1,318 @@
+#include "OcclusionCuller.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "PerfTimer.h"
+
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+
+#ifdef OCCLUSION_CULLER_SSE
+#include <xmmintrin.h>
+#endif
+
+OcclusionCuller::OcclusionCuller()
+{
+	tilesX = (OCCLUSION_WIDTH + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE;
+	tilesY = (OCCLUSION_HEIGHT + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE;
+	bins.resize(tilesX * tilesY);
+
+	// Every level halves the one before, down to a single texel
+	uint width = OCCLUSION_WIDTH, height = OCCLUSION_HEIGHT;
+	while (true)
+	{
+		Level level;
+		level.width = width;
+		level.height = height;
+		level.farthest.resize(width * height, 0.f);
+		if (!levels.empty())
+			level.nearest.resize(width * height, 0.f);
+		levels.push_back(level);
+
+		if (width == 1 && height == 1)
+			break;
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+	}
+}
+
+void OcclusionCuller::Begin(const float4x4& viewProj)
+{
+	this->viewProj = viewProj;
+
+	std::fill(levels[0].farthest.begin(), levels[0].farthest.end(), 0.f);
+	triangles.clear();
+	for (std::vector<uint>& bin : bins)
+		bin.clear();
+
+	stats = OcclusionStats();
+}
+
+void OcclusionCuller::AddOccluder(const std::vector<float3>& vertices, const uint* indices, uint numIndices, const float4x4& transform)
+{
+	PerfTimer timer;
+
+	const float4x4 mvp = viewProj * transform;
+	clipVertices.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); ++i)
+		clipVertices[i] = mvp * float4(vertices[i], 1.f);
+
+	const float halfWidth = OCCLUSION_WIDTH * 0.5f, halfHeight = OCCLUSION_HEIGHT * 0.5f;
+
+	for (uint i = 0; i + 2 < numIndices; i += 3)
+	{
+		float x[3], y[3], z[3];
+		bool behind = false;
+		for (uint corner = 0; corner < 3; ++corner)
+		{
+			const float4& clip = clipVertices[indices[i + corner]];
+			if (clip.w < OCCLUSION_NEAR_W)
+			{
+				behind = true;
+				break;
+			}
+
+			// Rows go down the screen like the buffer
+			z[corner] = 1.f / clip.w;
+			x[corner] = (clip.x * z[corner] + 1.f) * halfWidth;
+			y[corner] = (1.f - clip.y * z[corner]) * halfHeight;
+		}
+
+		// Clipping would only make the occluder smaller, dropping the triangle is still safe
+		if (behind)
+			continue;
+
+		// Counter clockwise triangles face the camera, with rows going down they come out negative
+		const float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+		if (area >= 0.f)
+			continue;
+
+		// Pixels whose centers can be inside
+		Triangle triangle;
+		triangle.minX = std::max(0, (int)ceilf(std::min(x[0], std::min(x[1], x[2])) - 0.5f));
+		triangle.minY = std::max(0, (int)ceilf(std::min(y[0], std::min(y[1], y[2])) - 0.5f));
+		triangle.maxX = std::min(OCCLUSION_WIDTH - 1, (int)floorf(std::max(x[0], std::max(x[1], x[2])) - 0.5f));
+		triangle.maxY = std::min(OCCLUSION_HEIGHT - 1, (int)floorf(std::max(y[0], std::max(y[1], y[2])) - 0.5f));
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+			continue;
+
+		for (uint edge = 0; edge < 3; ++edge)
+		{
+			const uint next = (edge + 1) % 3;
+			triangle.edgeA[edge] = y[next] - y[edge];
+			triangle.edgeB[edge] = x[edge] - x[next];
+			triangle.edgeC[edge] = -(triangle.edgeA[edge] * x[edge] + triangle.edgeB[edge] * y[edge]);
+		}
+
+		// 1/w is linear in screen space
+		const float dx1 = x[1] - x[0], dy1 = y[1] - y[0], dz1 = z[1] - z[0];
+		const float dx2 = x[2] - x[0], dy2 = y[2] - y[0], dz2 = z[2] - z[0];
+		triangle.depthA = -(dy1 * dz2 - dz1 * dy2) / area;
+		triangle.depthB = -(dz1 * dx2 - dx1 * dz2) / area;
+		triangle.depthC = z[0] - triangle.depthA * x[0] - triangle.depthB * y[0];
+
+		const uint id = (uint)triangles.size();
+		triangles.push_back(triangle);
+
+		for (int ty = triangle.minY / OCCLUSION_TILE_SIZE; ty <= triangle.maxY / OCCLUSION_TILE_SIZE; ++ty)
+		{
+			for (int tx = triangle.minX / OCCLUSION_TILE_SIZE; tx <= triangle.maxX / OCCLUSION_TILE_SIZE; ++tx)
+				bins[ty * tilesX + tx].push_back(id);
+		}
+	}
+
+	++stats.occluders;
+	stats.triangles = (uint)triangles.size();
+	stats.setupMs += timer.ReadMs();
+}
+
+void OcclusionCuller::Rasterize(JobSystem& jobs)
+{
+	PerfTimer timer;
+	jobs.ParallelFor(tilesX * tilesY, [this](uint tile)
+	{
+		PROFILE_ZONE("Rasterize Tile");
+		RasterizeTile(tile);
+	});
+	stats.rasterMs = timer.ReadMs();
+
+	timer.Start();
+	BuildHierarchy();
+	stats.hierarchyMs = timer.ReadMs();
+}
+
+void OcclusionCuller::RasterizeTile(uint tile)
+{
+	// Tiles never share pixels, so no locking
+	const int tileMinX = (tile % tilesX) * OCCLUSION_TILE_SIZE;
+	const int tileMinY = (tile / tilesX) * OCCLUSION_TILE_SIZE;
+	const int tileMaxX = std::min(tileMinX + OCCLUSION_TILE_SIZE, OCCLUSION_WIDTH) - 1;
+	const int tileMaxY = std::min(tileMinY + OCCLUSION_TILE_SIZE, OCCLUSION_HEIGHT) - 1;
+
+	float* depth = &levels[0].farthest[0];
+
+	for (uint id : bins[tile])
+	{
+		const Triangle& triangle = triangles[id];
+		const int minY = std::max(triangle.minY, tileMinY), maxY = std::min(triangle.maxY, tileMaxY);
+		const int maxX = std::min(triangle.maxX, tileMaxX);
+
+#ifdef OCCLUSION_CULLER_SSE
+		// Four pixels of a row at a time, lanes outside the triangle fail the edge tests
+		const int minX = std::max(triangle.minX, tileMinX) & ~3;
+		const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 edgeA0 = _mm_set1_ps(triangle.edgeA[0]), edgeA1 = _mm_set1_ps(triangle.edgeA[1]), edgeA2 = _mm_set1_ps(triangle.edgeA[2]);
+		const __m128 depthA = _mm_set1_ps(triangle.depthA);
+
+		for (int y = minY; y <= maxY; ++y)
+		{
+			const float py = y + 0.5f;
+			const __m128 row0 = _mm_set1_ps(triangle.edgeB[0] * py + triangle.edgeC[0]);
+			const __m128 row1 = _mm_set1_ps(triangle.edgeB[1] * py + triangle.edgeC[1]);
+			const __m128 row2 = _mm_set1_ps(triangle.edgeB[2] * py + triangle.edgeC[2]);
+			const __m128 rowDepth = _mm_set1_ps(triangle.depthB * py + triangle.depthC);
+			float* row = depth + y * OCCLUSION_WIDTH;
+
+			for (int x = minX; x <= maxX; x += 4)
+			{
+				const __m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+				const __m128 inside = _mm_and_ps(_mm_and_ps(
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA0, px), row0), zero),
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA1, px), row1), zero)),
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA2, px), row2), zero));
+				if (_mm_movemask_ps(inside) == 0)
+					continue;
+
+				const __m128 pixelDepth = _mm_add_ps(_mm_mul_ps(depthA, px), rowDepth);
+				const __m128 current = _mm_loadu_ps(row + x);
+				const __m128 nearest = _mm_max_ps(current, pixelDepth);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+			}
+		}
+#else
+		const int minX = std::max(triangle.minX, tileMinX);
+		for (int y = minY; y <= maxY; ++y)
+		{
+			const float py = y + 0.5f;
+			float* row = depth + y * OCCLUSION_WIDTH;
+			for (int x = minX; x <= maxX; ++x)
+			{
+				const float px = x + 0.5f;
+				if (triangle.edgeA[0] * px + triangle.edgeB[0] * py + triangle.edgeC[0] < 0.f ||
+					triangle.edgeA[1] * px + triangle.edgeB[1] * py + triangle.edgeC[1] < 0.f ||
+					triangle.edgeA[2] * px + triangle.edgeB[2] * py + triangle.edgeC[2] < 0.f)
+					continue;
+
+				const float pixelDepth = triangle.depthA * px + triangle.depthB * py + triangle.depthC;
+				if (pixelDepth > row[x])
+					row[x] = pixelDepth;
+			}
+		}
+#endif
+	}
+}
+
+void OcclusionCuller::BuildHierarchy()
+{
+	for (uint l = 1; l < levels.size(); ++l)
+	{
+		const Level& source = levels[l - 1];
+		const float* sourceFarthest = Farthest(l - 1);
+		const float* sourceNearest = Nearest(l - 1);
+		Level& level = levels[l];
+
+		for (uint y = 0; y < level.height; ++y)
+		{
+			const uint y0 = y * 2, y1 = std::min(y * 2 + 1, source.height - 1);
+			for (uint x = 0; x < level.width; ++x)
+			{
+				const uint x0 = x * 2, x1 = std::min(x * 2 + 1, source.width - 1);
+				const uint a = y0 * source.width + x0, b = y0 * source.width + x1;
+				const uint c = y1 * source.width + x0, d = y1 * source.width + x1;
+
+				level.farthest[y * level.width + x] = std::min(std::min(sourceFarthest[a], sourceFarthest[b]), std::min(sourceFarthest[c], sourceFarthest[d]));
+				level.nearest[y * level.width + x] = std::max(std::max(sourceNearest[a], sourceNearest[b]), std::max(sourceNearest[c], sourceNearest[d]));
+			}
+		}
+	}
+}
+
+bool OcclusionCuller::IsOccluded(const AABB& box)
+{
+	PerfTimer timer;
+	++stats.tested;
+
+	// Screen rectangle and nearest depth of the corners, a box reaching behind the eye is always visible
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	float nearest = 0.f;
+	bool inFront = true;
+	for (int i = 0; i < 8 && inFront; ++i)
+	{
+		const float4 clip = viewProj * float4(box.CornerPoint(i), 1.f);
+		if (clip.w < OCCLUSION_NEAR_W)
+		{
+			inFront = false;
+			break;
+		}
+
+		const float invW = 1.f / clip.w;
+		const float x = (clip.x * invW + 1.f) * OCCLUSION_WIDTH * 0.5f;
+		const float y = (1.f - clip.y * invW) * OCCLUSION_HEIGHT * 0.5f;
+		minX = std::min(minX, x); maxX = std::max(maxX, x);
+		minY = std::min(minY, y); maxY = std::max(maxY, y);
+		nearest = std::max(nearest, invW);
+	}
+
+	bool occluded = false;
+	if (inFront)
+	{
+		// Every pixel the rectangle touches
+		const int x0 = std::max(0, (int)floorf(minX)), x1 = std::min(OCCLUSION_WIDTH - 1, (int)floorf(maxX));
+		const int y0 = std::max(0, (int)floorf(minY)), y1 = std::min(OCCLUSION_HEIGHT - 1, (int)floorf(maxY));
+		if (x0 <= x1 && y0 <= y1)
+		{
+			uint level = 0;
+			while (level + 1 < levels.size() && ((x1 >> level) - (x0 >> level) >= OCCLUSION_TEST_TEXELS || (y1 >> level) - (y0 >> level) >= OCCLUSION_TEST_TEXELS))
+				++level;
+
+			occluded = TestRegion(level, x0, y0, x1, y1, nearest);
+		}
+	}
+
+	if (occluded)
+		++stats.occluded;
+	stats.testMs += timer.ReadMs();
+	return occluded;
+}
+
+bool OcclusionCuller::TestRegion(uint level, int x0, int y0, int x1, int y1, float nearest) const
+{
+	const uint width = levels[level].width;
+	const float* farthest = Farthest(level);
+	const float* closest = Nearest(level);
+
+	for (int ty = y0 >> level; ty <= (y1 >> level); ++ty)
+	{
+		for (int tx = x0 >> level; tx <= (x1 >> level); ++tx)
+		{
+			const uint texel = ty * width + tx;
+
+			// Behind everything drawn in this texel
+			if (nearest < farthest[texel])
+				continue;
+
+			// In front of everything, or down to single pixels without an answer
+			if (nearest > closest[texel] || level == 0)
+				return false;
+
+			// Somewhere in between, the finer level decides for the part of the box inside this texel
+			const int childX0 = std::max(x0, tx << level), childX1 = std::min(x1, ((tx + 1) << level) - 1);
+			const int childY0 = std::max(y0, ty << level), childY1 = std::min(y1, ((ty + 1) << level) - 1);
+			if (!TestRegion(level - 1, childX0, childY0, childX1, childY1, nearest))
+				return false;
+		}
+	}
+
+	return true;
+}
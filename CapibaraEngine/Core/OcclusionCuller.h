@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Globals.h"
+#include "Math/float3.h"
+#include "Math/float4.h"
+#include "Math/float4x4.h"
+#include "Geometry/AABB.h"
+#include <vector>
+
+class JobSystem;
+
+// Same SSE detection as the frustum culler, MathGeoLib is built without MATH_SSE
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define OCCLUSION_CULLER_SSE
+#endif
+
+#define OCCLUSION_WIDTH 256
+#define OCCLUSION_HEIGHT 128
+#define OCCLUSION_TILE_SIZE 32 // Pixels per side, tiles are rasterized in parallel
+#define OCCLUSION_MAX_OCCLUDERS 32
+#define OCCLUSION_MIN_OCCLUDER_SIZE 0.1f // Bounding sphere radius over half the view height
+#define OCCLUSION_TEST_TEXELS 4 // Boxes start testing at the level where they cover at most 4x4 texels
+#define OCCLUSION_NEAR_W 0.001f // Anything closer to the eye plane is never an occluder nor occluded
+
+struct OcclusionStats
+{
+	uint occluders = 0;
+	uint triangles = 0; // Front facing occluder triangles on screen
+	uint tested = 0;
+	uint occluded = 0;
+	double setupMs = 0.0;
+	double rasterMs = 0.0;
+	double hierarchyMs = 0.0;
+	double testMs = 0.0;
+};
+
+// Software occlusion culling on the CPU. A few large occluders are rasterized into a small depth
+// buffer, which is then reduced into a min / max hierarchy. Boxes are tested against the hierarchy
+// with their screen rectangle and nearest depth. Depth is stored as 1/w, 0 is empty.
+class OcclusionCuller
+{
+public:
+	OcclusionCuller();
+
+	void Begin(const float4x4& viewProj);
+
+	// Transforms, clips and bins the triangles, indices address the vertices in local space
+	void AddOccluder(const std::vector<float3>& vertices, const uint* indices, uint numIndices, const float4x4& transform);
+
+	// Rasterizes every tile on the workers and builds the hierarchy
+	void Rasterize(JobSystem& jobs);
+
+	bool IsOccluded(const AABB& box); // Counted in the stats
+
+	inline const OcclusionStats& GetStats() const { return stats; }
+
+private:
+	struct Triangle
+	{
+		float edgeA[3], edgeB[3], edgeC[3]; // Positive inside
+		float depthA, depthB, depthC; // 1/w plane in screen space
+		int minX, minY, maxX, maxY; // Pixels, inclusive
+	};
+
+	struct Level
+	{
+		uint width, height;
+		std::vector<float> farthest, nearest; // Occluder depth range in each texel
+	};
+
+	void RasterizeTile(uint tile);
+	void BuildHierarchy();
+	bool TestRegion(uint level, int x0, int y0, int x1, int y1, float nearest) const;
+
+	inline const float* Farthest(uint level) const { return &levels[level].farthest[0]; }
+	inline const float* Nearest(uint level) const { return level == 0 ? &levels[0].farthest[0] : &levels[level].nearest[0]; }
+
+private:
+	float4x4 viewProj;
+
+	std::vector<float4> clipVertices; // Scratch, one occluder at a time
+	std::vector<Triangle> triangles;
+	std::vector<std::vector<uint>> bins; // Triangle ids per tile
+	uint tilesX, tilesY;
+
+	std::vector<Level> levels; // Level 0 is the depth buffer itself, nearest and farthest are the same data
+
+	OcclusionStats stats;
+};
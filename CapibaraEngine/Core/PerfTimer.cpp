@@ -35,4 +35,19 @@ uint64 PerfTimer::ReadTicks() const
 	return SDL_GetPerformanceCounter() - started_at;
 }
 
+// ---------------------------------------------
+uint64 PerfTimer::GetTicks()
+{
+	return SDL_GetPerformanceCounter();
+}
+
+// ---------------------------------------------
+uint64 PerfTimer::GetFrequency()
+{
+	if (frequency == 0)
+		frequency = SDL_GetPerformanceFrequency();
+
+	return frequency;
+}
+
 
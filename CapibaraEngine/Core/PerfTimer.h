@@ -14,6 +14,9 @@ public:
 	double ReadMs() const;
 	uint64 ReadTicks() const;
 
+	static uint64 GetTicks(); // Raw performance counter
+	static uint64 GetFrequency(); // Ticks per second
+
 private:
 	uint64	started_at;
 	static uint64 frequency;
@@ -0,0 +1,227 @@
+#include "Profiler.h"
+#include "PerfTimer.h"
+#include "Application.h"
+#include "ModuleFileSystem.h"
+#include "p2Defs.h"
+
+#include "rapidjson-1.1.0/include/rapidjson/writer.h"
+#include "rapidjson-1.1.0/include/rapidjson/stringbuffer.h"
+
+#include <algorithm>
+
+#define PROFILER_RING_MASK (PROFILER_RING_SIZE - 1)
+
+std::atomic<bool> Profiler::recording(false);
+
+static thread_local void* threadBuffer = nullptr;
+
+Profiler& Profiler::Get()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+Profiler::Profiler()
+{
+}
+
+Profiler::~Profiler()
+{
+	for (ThreadBuffer* thread : threads)
+		RELEASE(thread);
+	threads.clear();
+}
+
+void Profiler::SetRecording(bool recording)
+{
+	Profiler::recording = recording;
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	ThreadBuffer* thread = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(mutex);
+	thread->name = name;
+}
+
+uint64 Profiler::BeginZone()
+{
+	++GetThreadBuffer()->depth;
+	return PerfTimer::GetTicks();
+}
+
+void Profiler::EndZone(const char* name, uint64 start)
+{
+	const uint64 end = PerfTimer::GetTicks();
+	ThreadBuffer* thread = GetThreadBuffer();
+	--thread->depth;
+
+	const uint written = thread->written.load(std::memory_order_relaxed);
+	ProfileEvent& event = thread->events[written & PROFILER_RING_MASK];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	event.thread = thread->index;
+	event.depth = thread->depth;
+	thread->written.store(written + 1, std::memory_order_release);
+}
+
+void Profiler::EndFrame(uint64 frame)
+{
+	const uint64 now = PerfTimer::GetTicks();
+	const bool keepFrame = !paused;
+	if (keepFrame)
+	{
+		lastFrame.clear();
+		lastFrameStart = frameStart;
+		lastFrameEnd = now;
+		lastFrameNumber = frame;
+	}
+	frameStart = now;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	for (ThreadBuffer* thread : threads)
+	{
+		const uint written = thread->written.load(std::memory_order_acquire);
+		if (written - thread->read > PROFILER_RING_SIZE)
+			thread->read = written - PROFILER_RING_SIZE; // Older zones were overwritten
+
+		for (; thread->read != written; ++thread->read)
+		{
+			const ProfileEvent& event = thread->events[thread->read & PROFILER_RING_MASK];
+			if (keepFrame)
+				lastFrame.push_back(event);
+			if (capturing && capture.size() < PROFILER_MAX_CAPTURE_ZONES)
+				capture.push_back(event);
+		}
+	}
+
+	if (keepFrame)
+	{
+		std::sort(lastFrame.begin(), lastFrame.end(), [](const ProfileEvent& a, const ProfileEvent& b)
+		{
+			return a.thread != b.thread ? a.thread < b.thread : a.start < b.start;
+		});
+	}
+
+	if (capturing)
+	{
+		++captureFrames;
+		if (capture.size() >= PROFILER_MAX_CAPTURE_ZONES)
+		{
+			LOG("Profiler capture full after %d frames, stopping it", captureFrames);
+			capturing = false;
+		}
+	}
+}
+
+void Profiler::StartCapture()
+{
+	capture.clear();
+	captureFrames = 0;
+	capturing = true;
+	SetRecording(true);
+}
+
+void Profiler::StopCapture()
+{
+	capturing = false;
+}
+
+bool Profiler::ExportChromeTrace(const char* path) const
+{
+	if (capture.empty())
+	{
+		LOG("Profiler capture is empty, nothing exported");
+		return false;
+	}
+
+	uint64 origin = capture[0].start;
+	for (const ProfileEvent& event : capture)
+		origin = event.start < origin ? event.start : origin;
+
+	const double ticksToUs = 1000000.0 / double(PerfTimer::GetFrequency());
+
+	rapidjson::StringBuffer sb;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+	writer.StartObject();
+	writer.String("displayTimeUnit");
+	writer.String("ms");
+	writer.String("traceEvents");
+	writer.StartArray();
+
+	// Complete events, each one with its begin and duration in microseconds
+	for (const ProfileEvent& event : capture)
+	{
+		writer.StartObject();
+		writer.String("name"); writer.String(event.name);
+		writer.String("ph"); writer.String("X");
+		writer.String("ts"); writer.Double(double(event.start - origin) * ticksToUs);
+		writer.String("dur"); writer.Double(double(event.end - event.start) * ticksToUs);
+		writer.String("pid"); writer.Uint(0);
+		writer.String("tid"); writer.Uint(event.thread);
+		writer.EndObject();
+	}
+
+	// Thread names as metadata events
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (const ThreadBuffer* thread : threads)
+		{
+			writer.StartObject();
+			writer.String("name"); writer.String("thread_name");
+			writer.String("ph"); writer.String("M");
+			writer.String("pid"); writer.Uint(0);
+			writer.String("tid"); writer.Uint(thread->index);
+			writer.String("args");
+			writer.StartObject();
+			writer.String("name"); writer.String(thread->name.c_str());
+			writer.EndObject();
+			writer.EndObject();
+		}
+	}
+
+	writer.EndArray();
+	writer.EndObject();
+
+	if (App->fileSystem->Save(path, sb.GetString(), (uint)sb.GetSize()) == 0)
+	{
+		LOG("Could not write profiler trace %s", path);
+		return false;
+	}
+
+	LOG("Profiler trace exported to %s: %d frames, %d zones", path, captureFrames, (uint)capture.size());
+	return true;
+}
+
+uint Profiler::GetThreadCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return (uint)threads.size();
+}
+
+std::string Profiler::GetThreadName(uint thread) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return thread < threads.size() ? threads[thread]->name : std::string();
+}
+
+double Profiler::TicksToMs(uint64 ticks)
+{
+	return 1000.0 * double(ticks) / double(PerfTimer::GetFrequency());
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+	if (threadBuffer == nullptr)
+	{
+		ThreadBuffer* thread = new ThreadBuffer();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		thread->index = (uint)threads.size();
+		thread->name = "Thread " + std::to_string(thread->index);
+		threads.push_back(thread);
+		threadBuffer = thread;
+	}
+	return static_cast<ThreadBuffer*>(threadBuffer);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Globals.h"
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <atomic>
+
+// Zones compile to nothing with PROFILER_DISABLED, otherwise they only check a flag while not recording.
+// Names must outlive the frame, string literals or module names.
+#ifndef PROFILER_DISABLED
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_FUNCTION()
+#endif
+
+#define PROFILER_RING_SIZE 16384 // Zones per thread between two frame ends, power of two
+#define PROFILER_MAX_CAPTURE_ZONES 2000000
+#define PROFILER_TRACE_FILE "profile.json"
+
+struct ProfileEvent
+{
+	const char* name;
+	uint64 start; // Performance counter ticks
+	uint64 end;
+	uint thread;
+	uint depth; // Zones open on the thread when this one started
+};
+
+// Scoped CPU profiler. Every thread writes its closed zones to its own ring, the main thread collects
+// them at the end of every frame. The last frame is kept for the editor and a capture can gather many
+// frames to export them as a Chrome trace (chrome://tracing or ui.perfetto.dev).
+class Profiler
+{
+public:
+	static Profiler& Get();
+
+	static inline bool IsRecording() { return recording.load(std::memory_order_relaxed); }
+	void SetRecording(bool recording);
+
+	void SetThreadName(const char* name); // For the calling thread
+
+	// Used by the zones, depth is tracked per thread
+	uint64 BeginZone();
+	void EndZone(const char* name, uint64 start);
+
+	// Main thread, once the frame is over and the workers are idle. The number tags the kept frame.
+	void EndFrame(uint64 frame);
+
+	void StartCapture(); // Also starts recording
+	void StopCapture();
+	inline bool IsCapturing() const { return capturing; }
+	inline uint GetCaptureFrameCount() const { return captureFrames; }
+	bool ExportChromeTrace(const char* path) const; // Through the file system, false if there is nothing to write
+
+	inline const std::vector<ProfileEvent>& GetLastFrame() const { return lastFrame; }
+	inline uint64 GetLastFrameStart() const { return lastFrameStart; }
+	inline uint64 GetLastFrameEnd() const { return lastFrameEnd; }
+	inline uint64 GetLastFrameNumber() const { return lastFrameNumber; } // Falls behind while paused
+	uint GetThreadCount() const;
+	std::string GetThreadName(uint thread) const;
+
+	static double TicksToMs(uint64 ticks);
+
+public:
+	bool paused = false; // Keeps the last frame on screen, zones are still collected
+
+private:
+	struct ThreadBuffer
+	{
+		ProfileEvent events[PROFILER_RING_SIZE];
+		std::atomic<uint> written;
+		uint read = 0;
+		uint depth = 0;
+		uint index = 0;
+		std::string name;
+
+		ThreadBuffer() : written(0) {}
+	};
+
+	Profiler();
+	~Profiler();
+
+	ThreadBuffer* GetThreadBuffer(); // Registers the calling thread the first time
+
+private:
+	static std::atomic<bool> recording;
+
+	mutable std::mutex mutex; // Guards the thread list
+	std::vector<ThreadBuffer*> threads;
+
+	std::vector<ProfileEvent> lastFrame;
+	uint64 frameStart = 0;
+	uint64 lastFrameStart = 0;
+	uint64 lastFrameEnd = 0;
+	uint64 lastFrameNumber = 0;
+
+	bool capturing = false;
+	uint captureFrames = 0;
+	std::vector<ProfileEvent> capture;
+};
+
+class ProfileZone
+{
+public:
+	inline ProfileZone(const char* name) : name(name), start(Profiler::IsRecording() ? Profiler::Get().BeginZone() : 0) {}
+	inline ~ProfileZone()
+	{
+		if (start != 0)
+			Profiler::Get().EndZone(name, start);
+	}
+
+private:
+	const char* name;
+	uint64 start; // 0 if the zone began while not recording
+};
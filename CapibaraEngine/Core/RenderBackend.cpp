@@ -0,0 +1,110 @@
+#include "RenderBackend.h"
+
+void RenderStats::Add(const RenderStats& other)
+{
+	frames += other.frames;
+	drawCalls += other.drawCalls;
+	triangles += other.triangles;
+	lines += other.lines;
+	instances += other.instances;
+	stateChanges += other.stateChanges;
+	uploads += other.uploads;
+	uploadedBytes += other.uploadedBytes;
+}
+
+void VertexFormat::Add(VertexAttribute attribute, uint components, VertexType type)
+{
+	Element& element = elements[(int)attribute];
+	element.components = components;
+	element.offset = stride;
+	element.type = type;
+
+	switch (type)
+	{
+	case VertexType::FLOAT: stride += components * 4; break;
+	case VertexType::HALF_FLOAT: stride += components * 2; break;
+	case VertexType::INT_2_10_10_10: stride += 4; break;
+	}
+}
+
+RenderBackend::RenderBackend()
+{
+	for (int i = 0; i < (int)RenderState::COUNT; ++i)
+		states[i] = false;
+}
+
+void RenderBackend::SetState(RenderState state, bool enabled)
+{
+	if (states[(int)state] == enabled)
+		return;
+
+	states[(int)state] = enabled;
+	ApplyState(state, enabled);
+	CountStateChange();
+}
+
+void RenderBackend::EndFrame()
+{
+	Present();
+
+	frameStats.frames = 1;
+	lastFrameStats = frameStats;
+	totalStats.Add(frameStats);
+	frameStats = RenderStats();
+}
+
+void RenderCommandList::Clear()
+{
+	commands.clear();
+	matrices.clear();
+}
+
+RenderCommand& RenderCommandList::Add(RenderCommandType type)
+{
+	RenderCommand command = {};
+	command.type = type;
+	commands.push_back(command);
+	return commands.back();
+}
+
+void RenderCommandList::SetState(RenderState state, bool enabled)
+{
+	RenderCommand& command = Add(RenderCommandType::SET_STATE);
+	command.id = (uint)state;
+	command.enabled = enabled;
+}
+
+void RenderCommandList::BindVertexArray(uint vertexArray)
+{
+	Add(RenderCommandType::BIND_VERTEX_ARRAY).id = vertexArray;
+}
+
+void RenderCommandList::BindTexture(uint texture)
+{
+	Add(RenderCommandType::BIND_TEXTURE).id = texture;
+}
+
+void RenderCommandList::Draw(const MeshDrawCall& call)
+{
+	RenderCommand& command = Add(RenderCommandType::DRAW);
+	command.indexType = call.indexType;
+	command.firstIndex = call.firstIndex;
+	command.numIndices = call.numIndices;
+	command.firstMatrix = (uint)matrices.size();
+	command.numMatrices = 1;
+
+	matrices.push_back(call.transform.Transposed());
+}
+
+void RenderCommandList::DrawInstanced(const MeshDrawCall* calls, uint numInstances)
+{
+	RenderCommand& command = Add(RenderCommandType::DRAW_INSTANCED);
+	command.indexType = calls[0].indexType;
+	command.firstIndex = calls[0].firstIndex;
+	command.numIndices = calls[0].numIndices;
+	command.firstMatrix = (uint)matrices.size();
+	command.numMatrices = numInstances;
+
+	for (uint i = 0; i < numInstances; ++i)
+		matrices.push_back(calls[i].transform.Transposed());
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "Globals.h"
+#include "Color.h"
+#include "Math/float3.h"
+#include "Math/float4x4.h"
+#include <vector>
+
+enum class RenderState
+{
+	DEPTH_TEST,
+	CULL_FACE,
+	LIGHTING,
+	TEXTURE_2D,
+	WIREFRAME,
+	COUNT
+};
+
+enum class BufferType
+{
+	VERTEX,
+	INDEX
+};
+
+enum class VertexAttribute
+{
+	POSITION,
+	NORMAL,
+	TEXCOORD,
+	COUNT
+};
+
+enum class VertexType
+{
+	FLOAT,
+	HALF_FLOAT,
+	INT_2_10_10_10 // Signed normalized, the three components in one 32 bit word
+};
+
+enum class IndexType
+{
+	UINT16,
+	UINT32
+};
+
+// Layout of one interleaved vertex buffer, attributes with no components are not present
+struct VertexFormat
+{
+	struct Element
+	{
+		uint components = 0;
+		uint offset = 0;
+		VertexType type = VertexType::FLOAT;
+	};
+
+	Element elements[(int)VertexAttribute::COUNT];
+	uint stride = 0;
+
+	void Add(VertexAttribute attribute, uint components, VertexType type = VertexType::FLOAT); // Appended after the last one
+	inline bool Has(VertexAttribute attribute) const { return elements[(int)attribute].components != 0; }
+	inline const Element& Get(VertexAttribute attribute) const { return elements[(int)attribute]; }
+};
+
+enum class TextureFilter
+{
+	NEAREST,
+	LINEAR,
+	MIPMAPS
+};
+
+struct RenderStats
+{
+	uint64 frames = 0;
+	uint64 drawCalls = 0;
+	uint64 triangles = 0;
+	uint64 lines = 0;
+	uint64 instances = 0; // Meshes drawn through instanced draws
+	uint64 stateChanges = 0;
+	uint64 uploads = 0;
+	uint64 uploadedBytes = 0;
+
+	void Add(const RenderStats& other);
+};
+
+// Color texture plus depth-stencil attachment
+struct RenderTarget
+{
+	uint frameBuffer = 0;
+	uint texture = 0;
+	uint depthBuffer = 0;
+	uint width = 0;
+	uint height = 0;
+};
+
+// Debug lines carry their own color so lines of every color go out in one draw
+struct LineVertex
+{
+	float3 position;
+	uint color; // RGBA8, red in the lowest byte
+
+	static inline uint PackColor(const Color& color)
+	{
+		return (uint)(color.r * 255.f + 0.5f) | ((uint)(color.g * 255.f + 0.5f) << 8)
+			| ((uint)(color.b * 255.f + 0.5f) << 16) | ((uint)(color.a * 255.f + 0.5f) << 24);
+	}
+};
+
+struct MeshDrawCall
+{
+	uint vertexArray = 0; // Vertex and index buffers with their layout, see CreateVertexArray
+	uint texture = 0; // Optional
+	uint firstIndex = 0; // Levels of detail are ranges of the same index buffer
+	uint numIndices = 0;
+	IndexType indexType = IndexType::UINT32;
+	float4x4 transform = float4x4::identity;
+};
+
+enum class RenderCommandType
+{
+	SET_STATE,
+	BIND_VERTEX_ARRAY,
+	BIND_TEXTURE,
+	DRAW,
+	DRAW_INSTANCED // Every matrix from firstMatrix on is one copy
+};
+
+struct RenderCommand
+{
+	RenderCommandType type;
+	uint id; // Vertex array, texture or RenderState
+	bool enabled; // SET_STATE
+	IndexType indexType;
+	uint firstIndex;
+	uint numIndices;
+	uint firstMatrix;
+	uint numMatrices;
+};
+
+// Draws recorded ahead of time, on any thread, and replayed by the thread that owns the context.
+// A list is self contained: it binds everything it uses before its first draw and leaves nothing
+// bound behind, so lists recorded in parallel can be replayed one after the other in any order.
+class RenderCommandList
+{
+public:
+	void Clear();
+
+	void SetState(RenderState state, bool enabled);
+	void BindVertexArray(uint vertexArray);
+	void BindTexture(uint texture);
+	void Draw(const MeshDrawCall& call); // With the vertex array and texture bound last
+	void DrawInstanced(const MeshDrawCall* calls, uint numInstances); // Geometry of the first call, transform of each
+
+	inline const std::vector<RenderCommand>& GetCommands() const { return commands; }
+	inline const float4x4* GetMatrices() const { return matrices.data(); }
+	inline bool IsEmpty() const { return commands.empty(); }
+
+private:
+	RenderCommand& Add(RenderCommandType type);
+
+private:
+	std::vector<RenderCommand> commands;
+	std::vector<float4x4> matrices; // Transposed while recording, column major like GL expects
+};
+
+// Everything the engine asks from the GPU goes through here. The OpenGL backend draws, the null
+// backend only counts, so the whole engine loop can run on a machine without a GPU or window.
+class RenderBackend
+{
+public:
+	RenderBackend();
+	virtual ~RenderBackend() {}
+
+	virtual const char* GetName() const = 0;
+	virtual bool Init() = 0;
+	virtual void CleanUp() = 0;
+	virtual void SetVSync(bool active) = 0;
+
+	// Resources, ids are 0 when creation fails
+	virtual uint CreateBuffer(BufferType type, const void* data, uint size) = 0;
+	virtual void DeleteBuffer(uint& buffer) = 0;
+	// Built once at upload, drawing a mesh then only needs to bind it. The buffers are not owned
+	virtual uint CreateVertexArray(uint vertexBuffer, uint indexBuffer, const VertexFormat& format) = 0;
+	virtual void DeleteVertexArray(uint& vertexArray) = 0;
+	virtual bool SupportsVertexType(VertexType type) const { return type == VertexType::FLOAT; }
+	virtual uint CreateTexture(uint width, uint height, uint channels, const void* pixels, TextureFilter filter) = 0;
+	virtual void DeleteTexture(uint& texture) = 0;
+	virtual bool CreateRenderTarget(uint width, uint height, RenderTarget& target) = 0;
+	virtual void DeleteRenderTarget(RenderTarget& target) = 0;
+
+	// Frame setup, a null target binds the window
+	virtual void BindRenderTarget(const RenderTarget* target) = 0;
+	virtual void Clear(const Color& color) = 0;
+	virtual void SetViewport(int x, int y, int width, int height) = 0;
+	virtual void SetCamera(const float4x4& view, const float4x4& projection) = 0;
+	virtual void SetLightPosition(const float3& position) = 0; // After SetCamera, the light follows the view
+
+	// Redundant changes are filtered out before reaching the backend
+	void SetState(RenderState state, bool enabled);
+	inline bool GetState(RenderState state) const { return states[(int)state]; }
+
+	// Drawing, meshes are recorded in command lists and replayed here. Record instanced draws only
+	// when they are supported, backends may fall back to one plain draw per copy
+	virtual void Execute(const RenderCommandList& list) = 0;
+	virtual bool SupportsInstancing() const { return false; }
+	virtual void DrawLineList(const LineVertex* vertices, uint numVertices, float width) = 0; // Pairs of points, streamed every call
+	virtual void DrawLineBuffer(uint vertexBuffer, uint numPoints, const Color& color, const float4x4& transform = float4x4::identity) = 0;
+
+	// Presents the frame and rolls the per frame counters over
+	void EndFrame();
+
+	inline const RenderStats& GetFrameStats() const { return lastFrameStats; }
+	inline const RenderStats& GetTotalStats() const { return totalStats; }
+
+protected:
+	virtual void ApplyState(RenderState state, bool enabled) = 0;
+	virtual void Present() = 0;
+
+	inline void CountDraw(uint numTriangles) { ++frameStats.drawCalls; frameStats.triangles += numTriangles; }
+	inline void CountLines(uint numLines) { ++frameStats.drawCalls; frameStats.lines += numLines; }
+	inline void CountInstances(uint numTriangles, uint numInstances) { ++frameStats.drawCalls; frameStats.triangles += (uint64)numTriangles * numInstances; frameStats.instances += numInstances; }
+	inline void CountUpload(uint64 bytes) { ++frameStats.uploads; frameStats.uploadedBytes += bytes; }
+	inline void CountStateChange() { ++frameStats.stateChanges; }
+
+private:
+	bool states[(int)RenderState::COUNT];
+
+	RenderStats frameStats;
+	RenderStats lastFrameStats;
+	RenderStats totalStats;
+};
@@ -0,0 +1,626 @@
+#include "RenderBackendGL.h"
+#include "Application.h"
+#include "ModuleWindow.h"
+
+#include "glew.h"
+#include "SDL/include/SDL_opengl.h"
+#include <gl/GL.h>
+#include <gl/GLU.h>
+#include <stddef.h>
+
+static inline GLenum ToGL(VertexType type)
+{
+	switch (type)
+	{
+	case VertexType::HALF_FLOAT: return GL_HALF_FLOAT;
+	case VertexType::INT_2_10_10_10: return GL_INT_2_10_10_10_REV;
+	default: return GL_FLOAT;
+	}
+}
+
+static inline GLenum ToGL(IndexType type)
+{
+	return type == IndexType::UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+static inline const void* IndexOffset(const RenderCommand& command)
+{
+	return (const void*)(size_t)(command.firstIndex * (command.indexType == IndexType::UINT16 ? 2 : 4));
+}
+
+// First of the four attribute slots that hold the instance matrix columns. NVIDIA aliases the generic
+// slots to the fixed arrays (0 gl_Vertex, 2 gl_Normal, 3 gl_Color, 8 + n gl_MultiTexCoord n), 12 to 15
+// are texture units this renderer never feeds
+#define INSTANCE_ATTRIBUTE 12
+#define INSTANCE_BUFFER_MIN_SIZE (64 * 1024)
+#define LINE_BUFFER_MIN_SIZE (64 * 1024)
+
+static const char* instanceVertexShader =
+	"#version 120\n"
+	"attribute vec4 instanceColumn0;\n"
+	"attribute vec4 instanceColumn1;\n"
+	"attribute vec4 instanceColumn2;\n"
+	"attribute vec4 instanceColumn3;\n"
+	"uniform bool useLighting;\n"
+	"varying vec2 texCoord;\n"
+	"varying vec4 lightColor;\n"
+	"void main()\n"
+	"{\n"
+	"	mat4 world = mat4(instanceColumn0, instanceColumn1, instanceColumn2, instanceColumn3);\n"
+	"	vec4 eyePosition = gl_ModelViewMatrix * (world * gl_Vertex);\n"
+	"	gl_Position = gl_ProjectionMatrix * eyePosition;\n"
+	"	texCoord = gl_MultiTexCoord0.xy;\n"
+	"	lightColor = vec4(1.0);\n"
+	"	if (useLighting)\n"
+	"	{\n"
+	"		// Light 0 with white color material, like the fixed function path\n"
+	"		vec3 normal = normalize(gl_NormalMatrix * (mat3(world[0].xyz, world[1].xyz, world[2].xyz) * gl_Normal));\n"
+	"		vec3 toLight = normalize(gl_LightSource[0].position.xyz - eyePosition.xyz);\n"
+	"		lightColor = gl_LightModel.ambient + gl_LightSource[0].ambient + gl_LightSource[0].diffuse * max(dot(normal, toLight), 0.0);\n"
+	"		lightColor = vec4(min(lightColor.rgb, vec3(1.0)), 1.0);\n"
+	"	}\n"
+	"}\n";
+
+static const char* instanceFragmentShader =
+	"#version 120\n"
+	"uniform sampler2D diffuseMap;\n"
+	"uniform bool useTexture;\n"
+	"varying vec2 texCoord;\n"
+	"varying vec4 lightColor;\n"
+	"void main()\n"
+	"{\n"
+	"	vec4 albedo = useTexture ? texture2D(diffuseMap, texCoord) : vec4(1.0);\n"
+	"	gl_FragColor = albedo * lightColor;\n"
+	"}\n";
+
+static GLuint CompileShader(GLenum type, const char* source)
+{
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+
+	GLint compiled = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+	if (compiled == GL_FALSE)
+	{
+		char info[512];
+		glGetShaderInfoLog(shader, sizeof(info), NULL, info);
+		LOG("Error compiling instancing shader: %s", info);
+		glDeleteShader(shader);
+		return 0;
+	}
+
+	return shader;
+}
+
+bool RenderBackendGL::Init()
+{
+	bool ret = true;
+
+	GLenum err = glewInit();
+	if (err != GLEW_OK)
+	{
+		LOG("Error initializing Glew! %s\n", glewGetErrorString(err));
+		return false;
+	}
+
+	LOG("Using Glew %s", glewGetString(GLEW_VERSION));
+	LOG("Vendor: %s", glGetString(GL_VENDOR));
+	LOG("Renderer: %s", glGetString(GL_RENDERER));
+	LOG("OpenGL version supported %s", glGetString(GL_VERSION));
+	LOG("GLSL: %s\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
+
+	if (!GLEW_VERSION_3_0 && !GLEW_ARB_vertex_array_object)
+	{
+		LOG("Error initializing OpenGL! Vertex array objects are not supported");
+		return false;
+	}
+
+	//Use Vsync
+	if (VSYNC && SDL_GL_SetSwapInterval(1) < 0)
+		LOG("Warning: Unable to set VSync! SDL Error: %s\n", SDL_GetError());
+
+	//Initialize Projection Matrix
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+
+	//Check for error
+	GLenum error = glGetError();
+	if (error != GL_NO_ERROR)
+	{
+		LOG("Error initializing OpenGL! %s\n", gluErrorString(error));
+		ret = false;
+	}
+
+	//Initialize Modelview Matrix
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	//Check for error
+	error = glGetError();
+	if (error != GL_NO_ERROR)
+	{
+		LOG("Error initializing OpenGL! %s\n", gluErrorString(error));
+		ret = false;
+	}
+
+	glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);
+	glClearDepth(1.0f);
+
+	//Initialize clear color
+	glClearColor(0.f, 0.f, 0.f, 1.f);
+
+	//Initialize BlendFunc
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	//Check for error
+	error = glGetError();
+	if (error != GL_NO_ERROR)
+	{
+		LOG("Error initializing OpenGL! %s\n", gluErrorString(error));
+		ret = false;
+	}
+
+	GLfloat LightModelAmbient[] = { 0.3f, 0.3f, 0.3f, 1.0f };
+	glLightModelfv(GL_LIGHT_MODEL_AMBIENT, LightModelAmbient);
+
+	lights[0].ref = GL_LIGHT0;
+	lights[0].ambient.Set(0.25f, 0.25f, 0.25f, 1.0f);
+	lights[0].diffuse.Set(0.9f, 0.9f, 0.9f, 1.0f);
+	lights[0].SetPos(0.0f, 0.0f, 2.5f);
+	lights[0].Init();
+	lights[0].Active(true);
+
+	GLfloat MaterialAmbient[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, MaterialAmbient);
+
+	GLfloat MaterialDiffuse[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, MaterialDiffuse);
+
+	glEnable(GL_COLOR_MATERIAL);
+	glEnable(GL_NORMALIZE); // Mesh normals are uploaded now, scaled transforms would change their length
+	SetState(RenderState::DEPTH_TEST, true);
+	SetState(RenderState::CULL_FACE, true);
+	SetState(RenderState::LIGHTING, true);
+	SetState(RenderState::TEXTURE_2D, true);
+
+	if (!CreateInstancing())
+		LOG("Instanced drawing not available, copies of a mesh are drawn one by one");
+
+	return ret;
+}
+
+void RenderBackendGL::CleanUp()
+{
+	DestroyInstancing();
+
+	lineBuffer ? glDeleteBuffers(1, &lineBuffer) : 0;
+	lineBuffer = 0;
+	lineBufferSize = 0;
+}
+
+bool RenderBackendGL::CreateInstancing()
+{
+	if (!GLEW_VERSION_3_3 && !(GLEW_VERSION_3_1 && GLEW_ARB_instanced_arrays))
+		return false;
+	coreDivisor = GLEW_VERSION_3_3 != 0;
+
+	GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, instanceVertexShader);
+	GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, instanceFragmentShader);
+	if (vertexShader == 0 || fragmentShader == 0)
+	{
+		vertexShader ? glDeleteShader(vertexShader) : 0;
+		fragmentShader ? glDeleteShader(fragmentShader) : 0;
+		return false;
+	}
+
+	instanceProgram = glCreateProgram();
+	glAttachShader(instanceProgram, vertexShader);
+	glAttachShader(instanceProgram, fragmentShader);
+	glBindAttribLocation(instanceProgram, INSTANCE_ATTRIBUTE + 0, "instanceColumn0");
+	glBindAttribLocation(instanceProgram, INSTANCE_ATTRIBUTE + 1, "instanceColumn1");
+	glBindAttribLocation(instanceProgram, INSTANCE_ATTRIBUTE + 2, "instanceColumn2");
+	glBindAttribLocation(instanceProgram, INSTANCE_ATTRIBUTE + 3, "instanceColumn3");
+	glLinkProgram(instanceProgram);
+
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(instanceProgram, GL_LINK_STATUS, &linked);
+	if (linked == GL_FALSE)
+	{
+		char info[512];
+		glGetProgramInfoLog(instanceProgram, sizeof(info), NULL, info);
+		LOG("Error linking instancing shader: %s", info);
+		DestroyInstancing();
+		return false;
+	}
+
+	useTextureLocation = glGetUniformLocation(instanceProgram, "useTexture");
+	useLightingLocation = glGetUniformLocation(instanceProgram, "useLighting");
+
+	glGenBuffers(1, &instanceBuffer);
+	return true;
+}
+
+void RenderBackendGL::DestroyInstancing()
+{
+	instanceProgram ? glDeleteProgram(instanceProgram) : 0;
+	instanceBuffer ? glDeleteBuffers(1, &instanceBuffer) : 0;
+	instanceProgram = 0;
+	instanceBuffer = 0;
+	instanceBufferSize = 0;
+}
+
+void RenderBackendGL::SetVSync(bool active)
+{
+	if (SDL_GL_SetSwapInterval(active ? 1 : 0) < 0)
+		LOG("Warning: Unable to set VSync! SDL Error: %s\n", SDL_GetError());
+}
+
+uint RenderBackendGL::CreateBuffer(BufferType type, const void* data, uint size)
+{
+	const GLenum target = type == BufferType::INDEX ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER;
+
+	GLuint buffer = 0;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(target, buffer);
+	glBufferData(target, size, data, GL_STATIC_DRAW);
+	glBindBuffer(target, 0);
+
+	CountUpload(size);
+	return buffer;
+}
+
+void RenderBackendGL::DeleteBuffer(uint& buffer)
+{
+	buffer ? glDeleteBuffers(1, &buffer) : 0;
+	buffer = 0;
+}
+
+uint RenderBackendGL::CreateVertexArray(uint vertexBuffer, uint indexBuffer, const VertexFormat& format)
+{
+	GLuint vertexArray = 0;
+	glGenVertexArrays(1, &vertexArray);
+	glBindVertexArray(vertexArray);
+
+	// The compatibility profile keeps the fixed function arrays inside the vertex array object too
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	const VertexFormat::Element& position = format.Get(VertexAttribute::POSITION);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(position.components, ToGL(position.type), format.stride, (const void*)(size_t)position.offset);
+
+	if (format.Has(VertexAttribute::NORMAL))
+	{
+		const VertexFormat::Element& normal = format.Get(VertexAttribute::NORMAL);
+		glEnableClientState(GL_NORMAL_ARRAY);
+		glNormalPointer(ToGL(normal.type), format.stride, (const void*)(size_t)normal.offset);
+	}
+
+	if (format.Has(VertexAttribute::TEXCOORD))
+	{
+		const VertexFormat::Element& texCoord = format.Get(VertexAttribute::TEXCOORD);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(texCoord.components, ToGL(texCoord.type), format.stride, (const void*)(size_t)texCoord.offset);
+	}
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	return vertexArray;
+}
+
+void RenderBackendGL::DeleteVertexArray(uint& vertexArray)
+{
+	vertexArray ? glDeleteVertexArrays(1, &vertexArray) : 0;
+	vertexArray = 0;
+}
+
+bool RenderBackendGL::SupportsVertexType(VertexType type) const
+{
+	switch (type)
+	{
+	case VertexType::HALF_FLOAT: return GLEW_VERSION_3_0 || GLEW_ARB_half_float_vertex;
+	case VertexType::INT_2_10_10_10: return GLEW_VERSION_3_3 || GLEW_ARB_vertex_type_2_10_10_10_rev;
+	default: return true;
+	}
+}
+
+uint RenderBackendGL::CreateTexture(uint width, uint height, uint channels, const void* pixels, TextureFilter filter)
+{
+	const GLenum format = channels == 3 ? GL_RGB : GL_RGBA;
+
+	GLuint texture = 0;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+
+	switch (filter)
+	{
+	case TextureFilter::NEAREST:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		break;
+	case TextureFilter::LINEAR:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		break;
+	case TextureFilter::MIPMAPS:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		break;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	CountUpload((uint64)width * height * channels);
+	return texture;
+}
+
+void RenderBackendGL::DeleteTexture(uint& texture)
+{
+	texture ? glDeleteTextures(1, &texture) : 0;
+	texture = 0;
+}
+
+bool RenderBackendGL::CreateRenderTarget(uint width, uint height, RenderTarget& target)
+{
+	target.width = width;
+	target.height = height;
+
+	glGenFramebuffers(1, &target.frameBuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.frameBuffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glGenTextures(1, &target.texture);
+	glBindTexture(GL_TEXTURE_2D, target.texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glBindTexture(GL_TEXTURE_2D, 0); //Unbind texture
+
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+
+	//Render Buffers
+	glGenRenderbuffers(1, &target.depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, target.depthBuffer);
+
+	//Bind tex data with render buffers
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, target.depthBuffer);
+
+	const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	if (!complete)
+		LOG("Error creating render target of %dx%d", width, height);
+
+	//After binding tex data, we must unbind renderbuffer and framebuffer not usefull anymore
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	return complete;
+}
+
+void RenderBackendGL::DeleteRenderTarget(RenderTarget& target)
+{
+	target.texture ? glDeleteTextures(1, &target.texture) : 0;
+	target.frameBuffer ? glDeleteFramebuffers(1, &target.frameBuffer) : 0;
+	target.depthBuffer ? glDeleteRenderbuffers(1, &target.depthBuffer) : 0;
+	target = RenderTarget();
+}
+
+void RenderBackendGL::BindRenderTarget(const RenderTarget* target)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, target ? target->frameBuffer : 0);
+	CountStateChange();
+}
+
+void RenderBackendGL::Clear(const Color& color)
+{
+	glClearColor(color.r, color.g, color.b, color.a);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void RenderBackendGL::SetViewport(int x, int y, int width, int height)
+{
+	glViewport(x, y, width, height);
+}
+
+void RenderBackendGL::SetCamera(const float4x4& view, const float4x4& projection)
+{
+	glMatrixMode(GL_PROJECTION);
+	glLoadMatrixf(projection.Transposed().ptr());
+	glMatrixMode(GL_MODELVIEW);
+	glLoadMatrixf(view.Transposed().ptr());
+}
+
+void RenderBackendGL::SetLightPosition(const float3& position)
+{
+	lights[0].SetPos(position.x, position.y, position.z);
+
+	for (uint i = 0; i < MAX_LIGHTS; ++i)
+		lights[i].Render();
+}
+
+void RenderBackendGL::Execute(const RenderCommandList& list)
+{
+	const float4x4* matrices = list.GetMatrices();
+	uint texture = 0;
+	glColor3f(1.0f, 1.0f, 1.0f);
+
+	for (const RenderCommand& command : list.GetCommands())
+	{
+		switch (command.type)
+		{
+		case RenderCommandType::SET_STATE:
+			SetState((RenderState)command.id, command.enabled);
+			break;
+
+		case RenderCommandType::BIND_VERTEX_ARRAY:
+			glBindVertexArray(command.id);
+			CountStateChange();
+			break;
+
+		case RenderCommandType::BIND_TEXTURE:
+			glBindTexture(GL_TEXTURE_2D, command.id);
+			texture = command.id;
+			CountStateChange();
+			break;
+
+		case RenderCommandType::DRAW:
+			glPushMatrix();
+			glMultMatrixf(matrices[command.firstMatrix].ptr());
+			glDrawElements(GL_TRIANGLES, command.numIndices, ToGL(command.indexType), IndexOffset(command));
+			glPopMatrix();
+			CountDraw(command.numIndices / 3);
+			break;
+
+		case RenderCommandType::DRAW_INSTANCED:
+			DrawInstanced(command, &matrices[command.firstMatrix], texture != 0);
+			break;
+		}
+	}
+
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void RenderBackendGL::DrawInstanced(const RenderCommand& command, const float4x4* matrices, bool textured)
+{
+	// Without the shader every copy is a plain draw
+	if (instanceProgram == 0)
+	{
+		for (uint i = 0; i < command.numMatrices; ++i)
+		{
+			glPushMatrix();
+			glMultMatrixf(matrices[i].ptr());
+			glDrawElements(GL_TRIANGLES, command.numIndices, ToGL(command.indexType), IndexOffset(command));
+			glPopMatrix();
+			CountDraw(command.numIndices / 3);
+		}
+		return;
+	}
+
+	// The list already holds the matrices column major, the shader rebuilds each one from four attributes
+	const uint size = command.numMatrices * sizeof(float4x4);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	if (instanceBufferOffset + size > instanceBufferSize)
+	{
+		// Orphan the old storage, draws that still read it keep it alive inside the driver
+		if (size > instanceBufferSize)
+			instanceBufferSize = size * 2 > INSTANCE_BUFFER_MIN_SIZE ? size * 2 : INSTANCE_BUFFER_MIN_SIZE;
+		glBufferData(GL_ARRAY_BUFFER, instanceBufferSize, NULL, GL_STREAM_DRAW);
+		instanceBufferOffset = 0;
+	}
+	glBufferSubData(GL_ARRAY_BUFFER, instanceBufferOffset, size, matrices);
+
+	// The instance columns are set on the bound vertex array and switched off again after the draw
+	for (uint c = 0; c < 4; ++c)
+	{
+		const GLuint attribute = INSTANCE_ATTRIBUTE + c;
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribPointer(attribute, 4, GL_FLOAT, GL_FALSE, sizeof(float4x4), (const void*)(size_t)(instanceBufferOffset + c * sizeof(float) * 4));
+		coreDivisor ? glVertexAttribDivisor(attribute, 1) : glVertexAttribDivisorARB(attribute, 1);
+	}
+	instanceBufferOffset += size;
+
+	glUseProgram(instanceProgram);
+	glUniform1i(useTextureLocation, textured && GetState(RenderState::TEXTURE_2D));
+	glUniform1i(useLightingLocation, GetState(RenderState::LIGHTING));
+
+	glDrawElementsInstanced(GL_TRIANGLES, command.numIndices, ToGL(command.indexType), IndexOffset(command), command.numMatrices);
+
+	for (uint c = 0; c < 4; ++c)
+	{
+		const GLuint attribute = INSTANCE_ATTRIBUTE + c;
+		coreDivisor ? glVertexAttribDivisor(attribute, 0) : glVertexAttribDivisorARB(attribute, 0);
+		glDisableVertexAttribArray(attribute);
+	}
+
+	glUseProgram(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	CountUpload(size);
+	CountStateChange();
+	CountInstances(command.numIndices / 3, command.numMatrices);
+}
+
+void RenderBackendGL::DrawLineList(const LineVertex* vertices, uint numVertices, float width)
+{
+	if (numVertices < 2)
+		return;
+
+	const uint size = numVertices * sizeof(LineVertex);
+	if (lineBuffer == 0)
+		glGenBuffers(1, &lineBuffer);
+
+	glBindBuffer(GL_ARRAY_BUFFER, lineBuffer);
+	if (size > lineBufferSize)
+		lineBufferSize = size > LINE_BUFFER_MIN_SIZE ? size : LINE_BUFFER_MIN_SIZE;
+	glBufferData(GL_ARRAY_BUFFER, lineBufferSize, NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, size, vertices);
+	CountUpload(size);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(LineVertex), (void*)offsetof(LineVertex, position));
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(LineVertex), (void*)offsetof(LineVertex, color));
+
+	glLineWidth(width);
+	glDrawArrays(GL_LINES, 0, numVertices);
+	glLineWidth(1.f);
+
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glColor3f(1.f, 1.f, 1.f);
+
+	CountLines(numVertices / 2);
+}
+
+void RenderBackendGL::DrawLineBuffer(uint vertexBuffer, uint numPoints, const Color& color, const float4x4& transform)
+{
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glVertexPointer(3, GL_FLOAT, 0, NULL);
+
+	glPushMatrix();
+	glMultMatrixf(transform.Transposed().ptr());
+	glColor4f(color.r, color.g, color.b, color.a);
+	glDrawArrays(GL_LINES, 0, numPoints);
+	glColor3f(1.f, 1.f, 1.f);
+	glPopMatrix();
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	CountLines(numPoints / 2);
+}
+
+void RenderBackendGL::ApplyState(RenderState state, bool enabled)
+{
+	switch (state)
+	{
+	case RenderState::DEPTH_TEST: enabled ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST); break;
+	case RenderState::CULL_FACE: enabled ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE); break;
+	case RenderState::LIGHTING: enabled ? glEnable(GL_LIGHTING) : glDisable(GL_LIGHTING); break;
+	case RenderState::TEXTURE_2D: enabled ? glEnable(GL_TEXTURE_2D) : glDisable(GL_TEXTURE_2D); break;
+	case RenderState::WIREFRAME: glPolygonMode(GL_FRONT_AND_BACK, enabled ? GL_LINE : GL_FILL); break;
+	}
+}
+
+void RenderBackendGL::Present()
+{
+	SDL_GL_SwapWindow(App->window->window);
+
+	// Next frame starts on fresh instance storage
+	instanceBufferOffset = instanceBufferSize;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "RenderBackend.h"
+#include "Light.h"
+
+#define MAX_LIGHTS 8
+
+// Fixed function OpenGL, expects the context to be current before Init
+class RenderBackendGL : public RenderBackend
+{
+public:
+	const char* GetName() const override { return "OpenGL"; }
+	bool Init() override;
+	void CleanUp() override;
+	void SetVSync(bool active) override;
+
+	uint CreateBuffer(BufferType type, const void* data, uint size) override;
+	void DeleteBuffer(uint& buffer) override;
+	uint CreateVertexArray(uint vertexBuffer, uint indexBuffer, const VertexFormat& format) override;
+	void DeleteVertexArray(uint& vertexArray) override;
+	bool SupportsVertexType(VertexType type) const override;
+	uint CreateTexture(uint width, uint height, uint channels, const void* pixels, TextureFilter filter) override;
+	void DeleteTexture(uint& texture) override;
+	bool CreateRenderTarget(uint width, uint height, RenderTarget& target) override;
+	void DeleteRenderTarget(RenderTarget& target) override;
+
+	void BindRenderTarget(const RenderTarget* target) override;
+	void Clear(const Color& color) override;
+	void SetViewport(int x, int y, int width, int height) override;
+	void SetCamera(const float4x4& view, const float4x4& projection) override;
+	void SetLightPosition(const float3& position) override;
+
+	void Execute(const RenderCommandList& list) override;
+	bool SupportsInstancing() const override { return instanceProgram != 0; }
+	void DrawLineList(const LineVertex* vertices, uint numVertices, float width) override;
+	void DrawLineBuffer(uint vertexBuffer, uint numPoints, const Color& color, const float4x4& transform = float4x4::identity) override;
+
+protected:
+	void ApplyState(RenderState state, bool enabled) override;
+	void Present() override;
+
+private:
+	bool CreateInstancing();
+	void DestroyInstancing();
+	void DrawInstanced(const RenderCommand& command, const float4x4* matrices, bool textured);
+
+private:
+	Light lights[MAX_LIGHTS];
+
+	// Instanced meshes go through a small shader that mimics the fixed function lighting,
+	// per instance matrices are streamed into one buffer that is orphaned when it fills up
+	uint instanceProgram = 0;
+	uint instanceBuffer = 0;
+	uint instanceBufferSize = 0;
+	uint instanceBufferOffset = 0;
+	bool coreDivisor = true;
+	int useTextureLocation = -1;
+	int useLightingLocation = -1;
+
+	// Debug lines are rewritten every draw, the buffer is orphaned instead of waiting on the GPU
+	uint lineBuffer = 0;
+	uint lineBufferSize = 0;
+};
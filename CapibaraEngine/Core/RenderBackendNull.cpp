@@ -0,0 +1,131 @@
+#include "RenderBackendNull.h"
+
+bool RenderBackendNull::Init()
+{
+	LOG("Using the null render backend, nothing will be drawn");
+
+	// Same starting state as the GL backend so the state change counts compare
+	SetState(RenderState::DEPTH_TEST, true);
+	SetState(RenderState::CULL_FACE, true);
+	SetState(RenderState::LIGHTING, true);
+	SetState(RenderState::TEXTURE_2D, true);
+
+	return true;
+}
+
+void RenderBackendNull::CleanUp()
+{
+	if (liveBuffers > 0 || liveTextures > 0 || liveVertexArrays > 0)
+		LOG("Null render backend: %d buffers, %d textures and %d vertex arrays were never deleted", liveBuffers, liveTextures, liveVertexArrays);
+}
+
+uint RenderBackendNull::CreateBuffer(BufferType type, const void* data, uint size)
+{
+	CountUpload(size);
+	++liveBuffers;
+	return nextId++;
+}
+
+void RenderBackendNull::DeleteBuffer(uint& buffer)
+{
+	if (buffer != 0)
+	{
+		--liveBuffers;
+		buffer = 0;
+	}
+}
+
+uint RenderBackendNull::CreateVertexArray(uint vertexBuffer, uint indexBuffer, const VertexFormat& format)
+{
+	++liveVertexArrays;
+	return nextId++;
+}
+
+void RenderBackendNull::DeleteVertexArray(uint& vertexArray)
+{
+	if (vertexArray != 0)
+	{
+		--liveVertexArrays;
+		vertexArray = 0;
+	}
+}
+
+uint RenderBackendNull::CreateTexture(uint width, uint height, uint channels, const void* pixels, TextureFilter filter)
+{
+	CountUpload((uint64)width * height * channels);
+	++liveTextures;
+	return nextId++;
+}
+
+void RenderBackendNull::DeleteTexture(uint& texture)
+{
+	if (texture != 0)
+	{
+		--liveTextures;
+		texture = 0;
+	}
+}
+
+bool RenderBackendNull::CreateRenderTarget(uint width, uint height, RenderTarget& target)
+{
+	target.width = width;
+	target.height = height;
+	target.frameBuffer = nextId++;
+	target.texture = CreateTexture(width, height, 3, nullptr, TextureFilter::LINEAR);
+	target.depthBuffer = nextId++;
+	return true;
+}
+
+void RenderBackendNull::DeleteRenderTarget(RenderTarget& target)
+{
+	DeleteTexture(target.texture);
+	target = RenderTarget();
+}
+
+void RenderBackendNull::BindRenderTarget(const RenderTarget* target)
+{
+	CountStateChange();
+}
+
+void RenderBackendNull::Execute(const RenderCommandList& list)
+{
+	// Counts the same work as the GL backend
+	for (const RenderCommand& command : list.GetCommands())
+	{
+		switch (command.type)
+		{
+		case RenderCommandType::SET_STATE:
+			SetState((RenderState)command.id, command.enabled);
+			break;
+
+		case RenderCommandType::BIND_VERTEX_ARRAY:
+		case RenderCommandType::BIND_TEXTURE:
+			CountStateChange();
+			break;
+
+		case RenderCommandType::DRAW:
+			CountDraw(command.numIndices / 3);
+			break;
+
+		case RenderCommandType::DRAW_INSTANCED:
+			CountUpload((uint64)command.numMatrices * sizeof(float4x4));
+			CountStateChange();
+			CountInstances(command.numIndices / 3, command.numMatrices);
+			break;
+		}
+	}
+}
+
+void RenderBackendNull::DrawLineList(const LineVertex* vertices, uint numVertices, float width)
+{
+	if (numVertices < 2)
+		return;
+
+	CountUpload((uint64)numVertices * sizeof(LineVertex));
+	CountLines(numVertices / 2);
+}
+
+void RenderBackendNull::DrawLineBuffer(uint vertexBuffer, uint numPoints, const Color& color, const float4x4& transform)
+{
+	CountLines(numPoints / 2);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "RenderBackend.h"
+
+// Headless backend, no window or GL context. Hands out fake ids and records what a frame
+// would have cost, live resource counts catch buffers that are never released.
+class RenderBackendNull : public RenderBackend
+{
+public:
+	const char* GetName() const override { return "Null"; }
+	bool Init() override;
+	void CleanUp() override;
+	void SetVSync(bool active) override {}
+
+	uint CreateBuffer(BufferType type, const void* data, uint size) override;
+	void DeleteBuffer(uint& buffer) override;
+	uint CreateVertexArray(uint vertexBuffer, uint indexBuffer, const VertexFormat& format) override;
+	void DeleteVertexArray(uint& vertexArray) override;
+	bool SupportsVertexType(VertexType type) const override { return true; }
+	uint CreateTexture(uint width, uint height, uint channels, const void* pixels, TextureFilter filter) override;
+	void DeleteTexture(uint& texture) override;
+	bool CreateRenderTarget(uint width, uint height, RenderTarget& target) override;
+	void DeleteRenderTarget(RenderTarget& target) override;
+
+	void BindRenderTarget(const RenderTarget* target) override;
+	void Clear(const Color& color) override {}
+	void SetViewport(int x, int y, int width, int height) override {}
+	void SetCamera(const float4x4& view, const float4x4& projection) override {}
+	void SetLightPosition(const float3& position) override {}
+
+	void Execute(const RenderCommandList& list) override;
+	bool SupportsInstancing() const override { return true; }
+	void DrawLineList(const LineVertex* vertices, uint numVertices, float width) override;
+	void DrawLineBuffer(uint vertexBuffer, uint numPoints, const Color& color, const float4x4& transform = float4x4::identity) override;
+
+	inline uint GetLiveBuffers() const { return liveBuffers; }
+	inline uint GetLiveTextures() const { return liveTextures; }
+	inline uint GetLiveVertexArrays() const { return liveVertexArrays; }
+
+protected:
+	void ApplyState(RenderState state, bool enabled) override {}
+	void Present() override {}
+
+private:
+	uint nextId = 1;
+	uint liveBuffers = 0;
+	uint liveTextures = 0;
+	uint liveVertexArrays = 0;
+};
@@ -0,0 +1,212 @@
+#include "RenderQueue.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Math/MathConstants.h"
+
+#include <string.h>
+#include <math.h>
+
+void RenderQueue::Begin(const float3& eye, float verticalFov, uint numPackets)
+{
+	this->eye = eye;
+	projectionScale = 1.f / tanf(verticalFov * 0.5f);
+	packets.resize(numPackets);
+	entries.resize(numPackets);
+}
+
+void RenderQueue::Submit(uint slot, const MeshDrawCall& call, RenderPass pass, const float3& worldCenter)
+{
+	entries[slot].key = MakeKey(pass, call.texture, call.vertexArray, worldCenter.Distance(eye));
+	entries[slot].packet = slot;
+	packets[slot] = call;
+}
+
+float RenderQueue::GetScreenSize(const float3& center, float radius) const
+{
+	const float distance = center.Distance(eye);
+	if (distance <= radius)
+		return FLOAT_INF;
+
+	return radius * projectionScale / distance;
+}
+
+static inline bool SameGeometry(const MeshDrawCall& a, const MeshDrawCall& b)
+{
+	return a.vertexArray == b.vertexArray && a.texture == b.texture && a.firstIndex == b.firstIndex && a.numIndices == b.numIndices;
+}
+
+bool RenderQueue::SameRun(uint a, uint b) const
+{
+	return (entries[a].key >> RENDER_KEY_PASS_SHIFT) == (entries[b].key >> RENDER_KEY_PASS_SHIFT) && SameGeometry(sorted[a], sorted[b]);
+}
+
+uint RenderQueue::GetChunkCount(uint numItems, const JobSystem& jobs)
+{
+	const uint chunks = (numItems + RENDER_QUEUE_CHUNK_SIZE - 1) / RENDER_QUEUE_CHUNK_SIZE;
+	const uint threads = jobs.GetNumThreads();
+	return chunks < threads ? chunks : threads;
+}
+
+void RenderQueue::Flush(RenderBackend* backend, JobSystem& jobs)
+{
+	const uint count = (uint)packets.size();
+	lastPacketCount = count;
+	lastInstancedCount = 0;
+	lastListCount = 0;
+	if (count == 0)
+		return;
+
+	{
+		PROFILE_ZONE("Sort");
+		RadixSort(entries, scratch);
+	}
+
+	const uint numChunks = GetChunkCount(count, jobs);
+	sorted.resize(count);
+	jobs.ParallelFor(numChunks, [&](uint chunk)
+	{
+		for (uint i = chunk * count / numChunks; i < (chunk + 1) * count / numChunks; ++i)
+			sorted[i] = packets[entries[i].packet];
+	});
+
+	// Chunks never split a run, so copies drawn instanced stay in one draw
+	chunkStarts.resize(numChunks + 1);
+	chunkStarts[0] = 0;
+	for (uint chunk = 1; chunk < numChunks; ++chunk)
+	{
+		uint start = chunk * count / numChunks;
+		if (start < chunkStarts[chunk - 1])
+			start = chunkStarts[chunk - 1];
+		while (start > 0 && start < count && SameRun(start - 1, start))
+			++start;
+		chunkStarts[chunk] = start;
+	}
+	chunkStarts[numChunks] = count;
+
+	const bool instancing = useInstancing && backend->SupportsInstancing();
+	if (lists.size() < numChunks)
+		lists.resize(numChunks);
+	chunkInstanced.assign(numChunks, 0);
+
+	jobs.ParallelFor(numChunks, [&](uint chunk)
+	{
+		PROFILE_ZONE("Record");
+		Record(chunkStarts[chunk], chunkStarts[chunk + 1], instancing, lists[chunk], chunkInstanced[chunk]);
+	});
+
+	// Always replayed in chunk order, the frame is the same whichever worker recorded what
+	PROFILE_ZONE("Submit");
+	const bool wireframe = backend->GetState(RenderState::WIREFRAME);
+	for (uint chunk = 0; chunk < numChunks; ++chunk)
+	{
+		if (!lists[chunk].IsEmpty())
+			backend->Execute(lists[chunk]);
+		lastInstancedCount += chunkInstanced[chunk];
+	}
+	backend->SetState(RenderState::WIREFRAME, wireframe);
+
+	lastListCount = numChunks;
+	packets.clear();
+	entries.clear();
+}
+
+void RenderQueue::Record(uint first, uint last, bool instancing, RenderCommandList& list, uint& instanced) const
+{
+	list.Clear();
+	instanced = 0;
+
+	uint64 pass = 0;
+	uint vertexArray = 0, texture = 0;
+	uint run = first;
+	while (run < last)
+	{
+		uint runEnd = run + 1;
+		while (runEnd < last && SameRun(run, runEnd))
+			++runEnd;
+
+		// Everything is set at the start of the list, afterwards only what changes
+		const MeshDrawCall& call = sorted[run];
+		const uint64 runPass = entries[run].key >> RENDER_KEY_PASS_SHIFT;
+		if (run == first || runPass != pass)
+		{
+			list.SetState(RenderState::WIREFRAME, runPass == (uint64)RenderPass::WIREFRAME);
+			pass = runPass;
+		}
+		if (run == first || call.vertexArray != vertexArray)
+		{
+			list.BindVertexArray(call.vertexArray);
+			vertexArray = call.vertexArray;
+		}
+		if (run == first || call.texture != texture)
+		{
+			list.BindTexture(call.texture);
+			texture = call.texture;
+		}
+
+		if (instancing && runEnd - run >= RENDER_QUEUE_MIN_INSTANCES)
+		{
+			list.DrawInstanced(&sorted[run], runEnd - run);
+			instanced += runEnd - run;
+		}
+		else
+		{
+			for (uint i = run; i < runEnd; ++i)
+				list.Draw(sorted[i]);
+		}
+		run = runEnd;
+	}
+}
+
+uint64 RenderQueue::MakeKey(RenderPass pass, uint texture, uint vertexArray, float depth)
+{
+	// Positive floats keep their order when compared as integers, the top 24 bits are plenty for sorting
+	uint32 depthBits;
+	depth = depth > 0.f ? depth : 0.f;
+	memcpy(&depthBits, &depth, sizeof(depthBits));
+
+	return ((uint64)pass << RENDER_KEY_PASS_SHIFT)
+		| ((uint64)(texture & 0xFFFF) << RENDER_KEY_TEXTURE_SHIFT)
+		| ((uint64)(vertexArray & 0xFFFFF) << RENDER_KEY_ARRAY_SHIFT)
+		| (uint64)(depthBits >> 7);
+}
+
+void RenderQueue::RadixSort(std::vector<RenderSortEntry>& entries, std::vector<RenderSortEntry>& scratch)
+{
+	const size_t count = entries.size();
+	if (count < 2)
+		return;
+
+	scratch.resize(count);
+	RenderSortEntry* source = &entries[0];
+	RenderSortEntry* destination = &scratch[0];
+
+	// Least significant byte first, stable so every pass keeps the order of the previous ones
+	for (uint shift = 0; shift < 64; shift += 8)
+	{
+		uint histogram[256] = {};
+		for (size_t i = 0; i < count; ++i)
+			++histogram[(source[i].key >> shift) & 0xFF];
+
+		// Every key shares this byte, nothing to reorder
+		if (histogram[(source[0].key >> shift) & 0xFF] == count)
+			continue;
+
+		uint offset = 0;
+		for (uint b = 0; b < 256; ++b)
+		{
+			const uint size = histogram[b];
+			histogram[b] = offset;
+			offset += size;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+			destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+
+		RenderSortEntry* swap = source;
+		source = destination;
+		destination = swap;
+	}
+
+	if (source != &entries[0])
+		memcpy(&entries[0], source, count * sizeof(RenderSortEntry));
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Globals.h"
+#include "RenderBackend.h"
+#include "Math/float3.h"
+#include <vector>
+
+class JobSystem;
+
+// Highest bits of the sort key, passes are drawn in this order
+enum class RenderPass
+{
+	OPAQUE_PASS = 0,
+	WIREFRAME = 1,
+	COUNT
+};
+
+// Key layout from the most significant bit: pass (4) | texture (16) | vertex array (20) | depth (24)
+#define RENDER_KEY_PASS_SHIFT 60
+#define RENDER_KEY_TEXTURE_SHIFT 44
+#define RENDER_KEY_ARRAY_SHIFT 24
+
+// Runs of packets with the same vertex array and texture at least this long become one instanced draw
+#define RENDER_QUEUE_MIN_INSTANCES 2
+
+// Packets per worker, smaller views are recorded on fewer threads since waking them costs more than it saves
+#define RENDER_QUEUE_CHUNK_SIZE 256
+
+struct RenderSortEntry
+{
+	uint64 key;
+	uint packet;
+};
+
+// Draw packets collected from the visible meshes of one view. Packets are sorted on a 64 bit key so
+// that state changes group together and, inside a group, meshes go front to back. Copies of the same
+// geometry end up next to each other and are drawn instanced. The sorted packets are split in chunks
+// that the workers record as command lists, which this thread then replays in chunk order.
+class RenderQueue
+{
+public:
+	// One slot per packet, each slot can then be filled from any thread
+	void Begin(const float3& eye, float verticalFov, uint numPackets);
+	void Submit(uint slot, const MeshDrawCall& call, RenderPass pass, const float3& worldCenter);
+	void Flush(RenderBackend* backend, JobSystem& jobs);
+
+	// Radius of a sphere on screen as a fraction of half the view height, picks the mesh levels of detail
+	float GetScreenSize(const float3& center, float radius) const;
+
+	inline uint GetLastPacketCount() const { return lastPacketCount; }
+	inline uint GetLastInstancedCount() const { return lastInstancedCount; }
+	inline uint GetLastListCount() const { return lastListCount; }
+
+	static uint64 MakeKey(RenderPass pass, uint texture, uint vertexArray, float depth);
+	static void RadixSort(std::vector<RenderSortEntry>& entries, std::vector<RenderSortEntry>& scratch);
+	static uint GetChunkCount(uint numItems, const JobSystem& jobs);
+
+	bool useInstancing = true;
+
+private:
+	bool SameRun(uint a, uint b) const; // Same pass and geometry, drawn instanced together
+	void Record(uint first, uint last, bool instancing, RenderCommandList& list, uint& instanced) const;
+
+private:
+	float3 eye = float3::zero;
+	float projectionScale = 1.f;
+
+	std::vector<MeshDrawCall> packets;
+	std::vector<RenderSortEntry> entries;
+	std::vector<RenderSortEntry> scratch;
+	std::vector<MeshDrawCall> sorted;
+
+	std::vector<uint> chunkStarts;
+	std::vector<uint> chunkInstanced;
+	std::vector<RenderCommandList> lists; // One per chunk, kept so their storage is reused
+
+	uint lastPacketCount = 0;
+	uint lastInstancedCount = 0;
+	uint lastListCount = 0;
+};
@@ -0,0 +1,138 @@
+#include "RenderView.h"
+#include "AABBTree.h"
+#include "GameObject.h"
+#include "ComponentTransform.h"
+#include "ComponentMesh.h"
+#include "RenderQueue.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Math/MathConstants.h"
+#include <algorithm>
+
+void RenderView::Cull(const Frustum& frustum, const AABBTree& tree, bool useOcclusion, JobSystem& jobs)
+{
+	PROFILE_ZONE("Cull");
+	this->frustum = frustum;
+
+	candidates.clear();
+	tree.QueryFrustum(frustum, candidates);
+
+	culler.Clear();
+	culler.Reserve((uint)candidates.size());
+	for (GameObject* go : candidates)
+		culler.Add(go->globalAABB);
+
+	visibleIndices.clear();
+	culler.Cull(frustum, visibleIndices);
+
+	visibleMeshes.clear();
+	for (uint index : visibleIndices)
+	{
+		if (ComponentMesh* mesh = candidates[index]->GetComponent<ComponentMesh>())
+			visibleMeshes.push_back(mesh);
+	}
+
+	occlusionStats = OcclusionStats();
+	if (useOcclusion)
+		CullOccluded(jobs);
+}
+
+void RenderView::CullOccluded(JobSystem& jobs)
+{
+	PROFILE_ZONE("Occlusion");
+	// Occluders are the meshes covering most of the view, same screen size measure as the LODs
+	const float projectionScale = 1.f / tanf(frustum.verticalFov * 0.5f);
+
+	occluders.clear();
+	for (ComponentMesh* mesh : visibleMeshes)
+	{
+		if (!mesh->isOccluder || mesh->vertices.empty())
+			continue;
+
+		const float radius = mesh->GetSphereRadius() * mesh->owner->transform->GetGlobalMatrix().GetScale().MaxElement();
+		const float distance = mesh->GetCenterPointInWorldCoords().Distance(frustum.pos);
+		const float screenSize = distance > radius ? radius / distance * projectionScale : FLOAT_INF;
+		if (screenSize >= OCCLUSION_MIN_OCCLUDER_SIZE)
+			occluders.push_back(std::make_pair(screenSize, mesh));
+	}
+
+	if (occluders.empty())
+		return;
+
+	std::sort(occluders.begin(), occluders.end(), [](const std::pair<float, ComponentMesh*>& a, const std::pair<float, ComponentMesh*>& b) { return a.first > b.first; });
+	if (occluders.size() > OCCLUSION_MAX_OCCLUDERS)
+		occluders.resize(OCCLUSION_MAX_OCCLUDERS);
+
+	// The level this view drew last frame is off by less than a screen pixel, far below an occlusion texel
+	occlusion.Begin(frustum.ViewProjMatrix());
+	for (const std::pair<float, ComponentMesh*>& occluder : occluders)
+	{
+		ComponentMesh* mesh = occluder.second;
+		const uint lod = GetLod(mesh) < mesh->lods.size() ? GetLod(mesh) : 0;
+		const uint firstIndex = mesh->lods.empty() ? 0 : mesh->lods[lod].firstIndex;
+		const uint numIndices = mesh->lods.empty() ? mesh->numIndices : mesh->lods[lod].numIndices;
+		const uint* indices = firstIndex < mesh->numIndices ? &mesh->indices[firstIndex] : &mesh->lodIndices[firstIndex - mesh->numIndices];
+
+		occlusion.AddOccluder(mesh->vertices, indices, numIndices, mesh->owner->transform->GetGlobalMatrix());
+	}
+	occlusion.Rasterize(jobs);
+
+	// Occluders stay, everything else has to show through them
+	auto isOccluder = [this](ComponentMesh* mesh)
+	{
+		for (const std::pair<float, ComponentMesh*>& occluder : occluders)
+		{
+			if (occluder.second == mesh)
+				return true;
+		}
+		return false;
+	};
+	visibleMeshes.erase(std::remove_if(visibleMeshes.begin(), visibleMeshes.end(), [&](ComponentMesh* mesh)
+	{
+		return !isOccluder(mesh) && occlusion.IsOccluded(mesh->owner->globalAABB);
+	}), visibleMeshes.end());
+
+	occlusionStats = occlusion.GetStats();
+}
+
+void RenderView::Render(RenderBackend* backend, RenderQueue& queue, bool useLods, JobSystem& jobs)
+{
+	PROFILE_ZONE("Render");
+	const uint count = (uint)visibleMeshes.size();
+	queue.Begin(frustum.pos, frustum.verticalFov, count);
+	visibleLods.resize(count);
+
+	// Each worker fills the queue slots of its own range of meshes, last frame levels are only read
+	const uint numChunks = RenderQueue::GetChunkCount(count, jobs);
+	jobs.ParallelFor(numChunks, [&](uint chunk)
+	{
+		for (uint i = chunk * count / numChunks; i < (chunk + 1) * count / numChunks; ++i)
+		{
+			ComponentMesh* mesh = visibleMeshes[i];
+			uint lod = 0;
+			if (useLods && mesh->lods.size() > 1)
+			{
+				const float worldRadius = mesh->GetSphereRadius() * mesh->owner->transform->GetGlobalMatrix().GetScale().MaxElement();
+				const float screenSize = queue.GetScreenSize(mesh->GetCenterPointInWorldCoords(), worldRadius);
+				lod = mesh->SelectLod(screenSize, GetLod(mesh));
+			}
+			visibleLods[i] = lod;
+
+			mesh->Submit(queue, i, lod);
+		}
+	});
+
+	nextLods.clear();
+	for (uint i = 0; i < count; ++i)
+		nextLods.push_back(std::make_pair(visibleMeshes[i], visibleLods[i]));
+	std::sort(nextLods.begin(), nextLods.end());
+	lods.swap(nextLods);
+
+	queue.Flush(backend, jobs);
+}
+
+uint RenderView::GetLod(const ComponentMesh* mesh) const
+{
+	auto it = std::lower_bound(lods.begin(), lods.end(), mesh, [](const std::pair<const ComponentMesh*, uint>& lod, const ComponentMesh* mesh) { return lod.first < mesh; });
+	return it != lods.end() && it->first == mesh ? it->second : 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Globals.h"
+#include "Geometry/Frustum.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include <vector>
+
+class GameObject;
+class ComponentMesh;
+class AABBTree;
+class RenderBackend;
+class RenderQueue;
+class JobSystem;
+
+// What one camera sees of the scene. Every camera culls the already updated scene on its own and
+// keeps its own level of detail choices, so views never interfere with each other.
+class RenderView
+{
+public:
+	// Meshes inside the frustum, the tree discards whole regions and the culler tests the tight boxes.
+	// With occlusion the biggest meshes on screen are rasterized on the workers and hide the rest.
+	void Cull(const Frustum& frustum, const AABBTree& tree, bool useOcclusion, JobSystem& jobs);
+
+	// Picks levels of detail and fills the queue on the workers, then draws with the camera already set on the backend
+	void Render(RenderBackend* backend, RenderQueue& queue, bool useLods, JobSystem& jobs);
+
+	uint GetLod(const ComponentMesh* mesh) const; // Level drawn last frame, 0 if the mesh was not drawn
+
+	inline const std::vector<ComponentMesh*>& GetVisibleMeshes() const { return visibleMeshes; }
+	inline uint GetCandidateCount() const { return (uint)candidates.size(); }
+	inline const OcclusionStats& GetOcclusionStats() const { return occlusionStats; }
+
+private:
+	void CullOccluded(JobSystem& jobs);
+
+private:
+	Frustum frustum;
+
+	std::vector<GameObject*> candidates; // Tree leaves, fat boxes
+	FrustumCuller culler;
+	std::vector<uint> visibleIndices;
+	std::vector<ComponentMesh*> visibleMeshes;
+
+	OcclusionCuller occlusion;
+	OcclusionStats occlusionStats;
+	std::vector<std::pair<float, ComponentMesh*>> occluders; // Screen size first
+
+	// Level of every mesh drawn last frame sorted by mesh, only visible meshes are kept. Both vectors
+	// are swapped every frame and keep their capacity, so a steady frame allocates nothing.
+	std::vector<std::pair<const ComponentMesh*, uint>> lods, nextLods;
+	std::vector<uint> visibleLods; // Written by the workers, one per visible mesh
+};
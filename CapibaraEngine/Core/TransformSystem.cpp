@@ -0,0 +1,177 @@
+#include "TransformSystem.h"
+#include "ComponentTransform.h"
+#include "FrameArena.h"
+
+#include <intrin.h>
+
+TransformSystem::TransformSystem()
+{
+}
+
+uint TransformSystem::Add(ComponentTransform* transform)
+{
+	// Appended as a root, so parent-before-child order still holds
+	const uint index = (uint)owners.size();
+	owners.push_back(transform);
+	parents.push_back(-1);
+	localMatrices.push_back(float4x4::identity);
+	worldMatrices.push_back(float4x4::identity);
+
+	if ((index >> 5) >= dirtyBits.size())
+		dirtyBits.push_back(0u);
+	SetDirty(index);
+
+	return index;
+}
+
+void TransformSystem::Remove(uint index)
+{
+	// Slot is compacted on the next sort, children of a removed transform become roots
+	owners[index] = nullptr;
+	parents[index] = -1;
+	++freeSlots;
+	needsSort = true;
+}
+
+void TransformSystem::SetParent(uint index, const ComponentTransform* parent)
+{
+	const int parentIndex = parent ? (int)parent->GetIndex() : -1;
+	parents[index] = parentIndex;
+
+	if (parentIndex > (int)index)
+		needsSort = true;
+
+	SetDirty(index);
+}
+
+void TransformSystem::SetLocalMatrix(uint index, const float4x4& local)
+{
+	localMatrices[index] = local;
+	SetDirty(index);
+}
+
+float4x4 TransformSystem::ComputeWorldMatrix(uint index) const
+{
+	// Children of a removed transform are roots already, the next sort only makes it explicit
+	float4x4 world = localMatrices[index];
+	for (int parent = parents[index]; parent >= 0 && owners[parent] != nullptr; parent = parents[parent])
+		world = localMatrices[parent].Mul(world);
+	return world;
+}
+
+void TransformSystem::Update()
+{
+	if (needsSort)
+		Sort();
+
+	const uint count = (uint)owners.size();
+
+	// Parents come first, so a dirty parent has already marked its children when we reach them
+	for (uint i = 0; i < count; ++i)
+	{
+		const int parent = parents[i];
+		if (parent >= 0 && IsDirty((uint)parent))
+			SetDirty(i);
+
+		if (IsDirty(i))
+			worldMatrices[i] = parent >= 0 ? worldMatrices[parent].Mul(localMatrices[i]) : localMatrices[i];
+	}
+
+	// Notify moved transforms and clear the bits
+	lastUpdatedCount = 0;
+	for (uint word = 0; word < dirtyBits.size(); ++word)
+	{
+		unsigned long bit;
+		while (_BitScanForward(&bit, dirtyBits[word]))
+		{
+			dirtyBits[word] &= dirtyBits[word] - 1;
+			const uint index = (word << 5) + bit;
+			if (owners[index] != nullptr)
+			{
+				owners[index]->OnWorldMatrixChanged();
+				++lastUpdatedCount;
+			}
+		}
+	}
+}
+
+void TransformSystem::Sort()
+{
+	const uint count = (uint)owners.size();
+
+	// Orphans of removed transforms become roots
+	for (uint i = 0; i < count; ++i)
+	{
+		if (parents[i] >= 0 && owners[parents[i]] == nullptr)
+		{
+			parents[i] = -1;
+			SetDirty(i);
+		}
+	}
+
+	// Children lists in counting-sort layout, the scratch lives in the frame arena
+	FrameVector<uint> childStart(count + 1, 0);
+	for (uint i = 0; i < count; ++i)
+	{
+		if (owners[i] != nullptr && parents[i] >= 0)
+			++childStart[parents[i] + 1];
+	}
+	for (uint i = 0; i < count; ++i)
+		childStart[i + 1] += childStart[i];
+
+	FrameVector<uint> children(childStart[count]);
+	FrameVector<uint> fill(childStart.begin(), childStart.end() - 1);
+	for (uint i = 0; i < count; ++i)
+	{
+		if (owners[i] != nullptr && parents[i] >= 0)
+			children[fill[parents[i]]++] = i;
+	}
+
+	// Breadth first from the roots keeps every parent in front of its children
+	FrameVector<uint> order;
+	order.reserve(count - freeSlots);
+	for (uint i = 0; i < count; ++i)
+	{
+		if (owners[i] != nullptr && parents[i] < 0)
+			order.push_back(i);
+	}
+	for (uint head = 0; head < order.size(); ++head)
+	{
+		const uint node = order[head];
+		for (uint c = childStart[node]; c < childStart[node + 1]; ++c)
+			order.push_back(children[c]);
+	}
+
+	FrameVector<int> newIndex(count, -1);
+	for (uint i = 0; i < order.size(); ++i)
+		newIndex[order[i]] = (int)i;
+
+	const uint newCount = (uint)order.size();
+	std::vector<float4x4> newLocal(newCount);
+	std::vector<float4x4> newWorld(newCount);
+	std::vector<int> newParents(newCount);
+	std::vector<ComponentTransform*> newOwners(newCount);
+	std::vector<uint32> newDirty((newCount + 31) >> 5, 0u);
+
+	for (uint i = 0; i < newCount; ++i)
+	{
+		const uint old = order[i];
+		newLocal[i] = localMatrices[old];
+		newWorld[i] = worldMatrices[old];
+		newParents[i] = parents[old] >= 0 ? newIndex[parents[old]] : -1;
+		newOwners[i] = owners[old];
+		if (IsDirty(old))
+			newDirty[i >> 5] |= (1u << (i & 31));
+
+		newOwners[i]->SetIndex(i);
+	}
+
+	localMatrices.swap(newLocal);
+	worldMatrices.swap(newWorld);
+	parents.swap(newParents);
+	owners.swap(newOwners);
+	dirtyBits.swap(newDirty);
+
+	freeSlots = 0;
+	needsSort = false;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Globals.h"
+#include "Math/float4x4.h"
+#include <vector>
+
+class ComponentTransform;
+
+// Flat transform hierarchy. Local and world matrices live in contiguous arrays sorted parent-before-child,
+// so world matrices are recomputed in one linear pass over the dirty bits instead of recursing the GameObject tree.
+class TransformSystem
+{
+public:
+	TransformSystem();
+
+	uint Add(ComponentTransform* transform);
+	void Remove(uint index);
+
+	void SetParent(uint index, const ComponentTransform* parent);
+	void SetLocalMatrix(uint index, const float4x4& local);
+
+	inline const float4x4& GetLocalMatrix(uint index) const { return localMatrices[index]; }
+	inline const float4x4& GetWorldMatrix(uint index) const { return worldMatrices[index]; }
+
+	// Up to date even before the next Update, walking the parent chain
+	float4x4 ComputeWorldMatrix(uint index) const;
+
+	// Recomputes every dirty world matrix and notifies the transforms that moved
+	void Update();
+
+	inline uint Size() const { return (uint)owners.size(); }
+	inline uint GetLastUpdatedCount() const { return lastUpdatedCount; }
+
+private:
+	void Sort();
+
+	inline void SetDirty(uint index) { dirtyBits[index >> 5] |= (1u << (index & 31)); }
+	inline bool IsDirty(uint index) const { return (dirtyBits[index >> 5] & (1u << (index & 31))) != 0; }
+
+private:
+	std::vector<float4x4> localMatrices;
+	std::vector<float4x4> worldMatrices;
+	std::vector<int> parents; // -1 for roots
+	std::vector<ComponentTransform*> owners; // nullptr for removed slots until the next sort
+	std::vector<uint32> dirtyBits;
+
+	bool needsSort = false;
+	uint freeSlots = 0;
+	uint lastUpdatedCount = 0;
+};
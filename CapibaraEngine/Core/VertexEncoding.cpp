@@ -0,0 +1,96 @@
+#include "VertexEncoding.h"
+
+#include <string.h>
+
+static inline uint PackSnorm10(float value)
+{
+	value = value < -1.f ? -1.f : (value > 1.f ? 1.f : value);
+	const int quantized = (int)(value * 511.f + (value >= 0.f ? 0.5f : -0.5f));
+	return (uint)quantized & 0x3FF;
+}
+
+static inline float UnpackSnorm10(uint bits)
+{
+	// Sign extend the 10 bit field
+	const int value = (int)(bits << 22) >> 22;
+	const float unpacked = (float)value / 511.f;
+	return unpacked < -1.f ? -1.f : unpacked;
+}
+
+uint VertexEncoding::PackNormal(const float3& normal)
+{
+	return PackSnorm10(normal.x) | (PackSnorm10(normal.y) << 10) | (PackSnorm10(normal.z) << 20);
+}
+
+float3 VertexEncoding::UnpackNormal(uint packed)
+{
+	return float3(UnpackSnorm10(packed & 0x3FF), UnpackSnorm10((packed >> 10) & 0x3FF), UnpackSnorm10((packed >> 20) & 0x3FF));
+}
+
+unsigned short VertexEncoding::FloatToHalf(float value)
+{
+	uint bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	const uint sign = (bits >> 16) & 0x8000;
+	const int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+	uint mantissa = bits & 0x7FFFFF;
+
+	// NaN stays NaN, infinity and overflow become infinity
+	if (((bits >> 23) & 0xFF) == 0xFF)
+		return (unsigned short)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+	if (exponent >= 31)
+		return (unsigned short)(sign | 0x7C00);
+
+	if (exponent <= 0)
+	{
+		// Subnormal half, or zero when too small
+		if (exponent < -10)
+			return (unsigned short)sign;
+		mantissa |= 0x800000;
+		const uint shift = (uint)(14 - exponent);
+		uint half = mantissa >> shift;
+		const uint remainder = mantissa & ((1u << shift) - 1);
+		const uint halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half & 1)))
+			++half;
+		return (unsigned short)(sign | half);
+	}
+
+	// Round to nearest even, a carry into the exponent is still the right result
+	uint half = ((uint)exponent << 10) | (mantissa >> 13);
+	const uint remainder = mantissa & 0x1FFF;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+		++half;
+	return (unsigned short)(sign | half);
+}
+
+float VertexEncoding::HalfToFloat(unsigned short half)
+{
+	const uint sign = (uint)(half & 0x8000) << 16;
+	const uint exponent = (half >> 10) & 0x1F;
+	uint mantissa = half & 0x3FF;
+
+	uint bits;
+	if (exponent == 0x1F)
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	else if (exponent != 0)
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	else if (mantissa == 0)
+		bits = sign;
+	else
+	{
+		// Subnormal half, normalize it for the float exponent
+		int e = -1;
+		do
+		{
+			++e;
+			mantissa <<= 1;
+		} while ((mantissa & 0x400) == 0);
+		bits = sign | ((uint)(127 - 15 - e) << 23) | ((mantissa & 0x3FF) << 13);
+	}
+
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Globals.h"
+#include "Math/float2.h"
+#include "Math/float3.h"
+
+// Compact encodings shared by the GPU vertex buffers and the binary mesh cache
+namespace VertexEncoding
+{
+	// Meshes up to this many vertices are indexed with 16 bits
+	const uint MAX_SHORT_INDEX_VERTICES = 65536;
+
+	// Signed normalized 10:10:10:2, the layout of GL_INT_2_10_10_10_REV with w left at 0
+	uint PackNormal(const float3& normal);
+	float3 UnpackNormal(uint packed);
+
+	// IEEE 754 half precision, rounded to nearest
+	unsigned short FloatToHalf(float value);
+	float HalfToFloat(unsigned short half);
+
+	inline uint PackTexCoord(const float2& uv) { return (uint)FloatToHalf(uv.x) | ((uint)FloatToHalf(uv.y) << 16); }
+	inline float2 UnpackTexCoord(uint packed) { return float2(HalfToFloat((unsigned short)(packed & 0xFFFF)), HalfToFloat((unsigned short)(packed >> 16))); }
+}
@@ -2,8 +2,14 @@
 #include "Globals.h"
 #include "Application.h"
 #include "ModuleEditor.h"
+#include <mutex>
+
 void log(const char file[], int line, const char* format, ...)
 {
+	// Importers and other systems log from worker threads
+	static std::mutex logMutex;
+	std::lock_guard<std::mutex> lock(logMutex);
+
 	static char tmp_string[4096];
 	static char tmp_string2[4096];
 	static va_list  ap;